@@ -1,5 +1,76 @@
 import os
 import argparse
+import hashlib
+import json
+import shutil
+
+estimationFolder = "./data/estimation/"
+hashCacheFile = estimationFolder + "hashcache.json"
+
+def loadHashCache():
+    if not os.path.isfile(hashCacheFile):
+        return {}
+    with open(hashCacheFile) as f:
+        return json.load(f)
+
+def saveHashCache(cache):
+    os.makedirs(os.path.dirname(hashCacheFile), exist_ok=True)
+    with open(hashCacheFile, "w") as f:
+        json.dump(cache, f)
+
+def hashFile(path, cache):
+    # Files are only read again when their size or modification time changed
+    path = os.path.abspath(path)
+    st = os.stat(path)
+    cached = cache.get(path)
+    if cached is not None and cached[0] == st.st_size and cached[1] == st.st_mtime_ns:
+        return cached[2]
+
+    h = hashlib.sha256()
+    with open(path, "rb") as f:
+        for block in iter(lambda: f.read(1 << 20), b""):
+            h.update(block)
+    cache[path] = [st.st_size, st.st_mtime_ns, h.hexdigest()]
+    return h.hexdigest()
+
+def hashPath(path, cache):
+    if path is None or not os.path.exists(path):
+        return None
+    if os.path.isfile(path):
+        return hashFile(path, cache)
+
+    h = hashlib.sha256()
+    for root, dirs, files in os.walk(path):
+        dirs.sort()
+        for name in sorted(files):
+            filePath = os.path.join(root, name)
+            h.update(os.path.relpath(filePath, path).encode())
+            h.update(hashFile(filePath, cache).encode())
+    return h.hexdigest()
+
+def runStage(name, command, inputs, output, cache, force, debug):
+    # The hashes of the inputs, the parameters and the executable are stored next to the output. Debug mode
+    # does not change the output and is not part of it.
+    tool = shutil.which(command[0])
+    hashes = {path: hashPath(path, cache) for path in inputs}
+    hashes[command[0]] = hashPath(tool, cache)
+    key = {"inputs": hashes, "command": command[1:]}
+
+    sidecar = output + ".inputs.json"
+    if not force and os.path.isfile(output) and os.path.isfile(sidecar):
+        with open(sidecar) as f:
+            if json.load(f) == key:
+                print("[calibrate.py] %s is up to date, skipping %s" % (output, name))
+                return
+
+    print("[calibrate.py] Running %s" % name)
+    if os.system(" ".join(command + (["-d"] if debug else []))) != 0 or not os.path.isfile(output):
+        print("[calibrate.py] %s failed" % name)
+        saveHashCache(cache)
+        exit(1)
+
+    with open(sidecar, "w") as f:
+        json.dump(key, f, indent=1)
 
 if __name__ == "__main__":
     parser = argparse.ArgumentParser("calibrate.py", "Calibrate a full system: camera calibration, mirror calibration and procam calibration")
@@ -7,7 +78,11 @@ if __name__ == "__main__":
     parser.add_argument("patterns", type=str, help="Path to the patterns folder to use for the procam calibration (patterns that are projected, or were projected on the calibration board)")
     parser.add_argument("-m", "--mirrorRecording", type=str, help="Path to the recording folder for mirror calibration (will save calibration images here, or read them from here). Only needed for mirrored setups (recording folder name starts with 'S'). The folder name should start with 'F' for full view and with 'M' for Real-Virtual observations.")
     parser.add_argument("-d", "--debug", action="store_true", help="Enable debug mode (shows images during calibration)")
-    
+    parser.add_argument("--camArgs", type=str, default="", help="Extra arguments for CamCalib")
+    parser.add_argument("--mirrorArgs", type=str, default="", help="Extra arguments for MirrorCalib")
+    parser.add_argument("--procamArgs", type=str, default="", help="Extra arguments for ProcamCalib")
+    parser.add_argument("-f", "--force", action="store_true", help="Run every stage, also when its inputs did not change")
+
     args = parser.parse_args()
 
     sequenceName = os.path.basename(args.recording)
@@ -16,9 +91,19 @@ if __name__ == "__main__":
         print("A mirrored recording requires a mirrorRecording..")
         exit(1)
 
-    os.system("CamCalib %s %s"%(args.recording, "-d" if args.debug else ""))
+    # Stages only run when one of their inputs changed since the last run. A stage that runs changes its output,
+    # which is an input of the next stages.
+    cache = loadHashCache()
+
+    camCalib = estimationFolder + "camCalib/" + sequenceName + ".json"
+    mirrorCalib = estimationFolder + "mirrorCalib/" + sequenceName + ".json"
+    procamCalib = estimationFolder + "procamCalib/" + sequenceName + ".json"
+
+    runStage("camera calibration", ["CamCalib", args.recording, args.camArgs], [args.recording], camCalib, cache, args.force, args.debug)
     if sequenceName.startswith("S"):
-        os.system("MirrorCalib %s %s %s"%(args.mirrorRecording, "./data/estimation/camCalib/"+sequenceName+".json", "-d" if args.debug else ""))
-        os.system("ProcamCalib %s %s %s --mirrorcalib %s %s"%(args.recording, args.patterns, "./data/estimation/camCalib/"+sequenceName+".json", "./data/estimation/mirrorCalib/"+sequenceName+".json", "-d" if args.debug else ""))
+        runStage("mirror calibration", ["MirrorCalib", args.mirrorRecording, camCalib, args.mirrorArgs], [args.mirrorRecording, camCalib], mirrorCalib, cache, args.force, args.debug)
+        runStage("procam calibration", ["ProcamCalib", args.recording, args.patterns, camCalib, "--mirrorcalib", mirrorCalib, args.procamArgs], [args.recording, args.patterns, camCalib, mirrorCalib], procamCalib, cache, args.force, args.debug)
     else:
-        os.system("ProcamCalib %s %s %s %s"%(args.recording, args.patterns, "./data/estimation/camCalib/"+sequenceName+".json", "-d" if args.debug else ""))
+        runStage("procam calibration", ["ProcamCalib", args.recording, args.patterns, camCalib, args.procamArgs], [args.recording, args.patterns, camCalib], procamCalib, cache, args.force, args.debug)
+
+    saveHashCache(cache)
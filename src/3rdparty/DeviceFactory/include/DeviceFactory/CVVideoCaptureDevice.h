@@ -22,6 +22,9 @@ public:
     std::string getDriver() { return "CVVideoCapture"; }
 
     virtual int numberOfFrames() const;
+    virtual double frameRate() const;
+    virtual double framePosition() const;
+    virtual bool seek(double seconds);
 
     std::vector<std::string> split(const std::string &s, char delim);
 
@@ -39,6 +42,7 @@ private:
 
     int m_framesInSequence;
     int m_frameID;
+    bool m_grayscale;
 };
 }
 
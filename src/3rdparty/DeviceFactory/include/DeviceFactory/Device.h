@@ -63,6 +63,25 @@ public:
 
     virtual int numberOfFrames() const { return std::numeric_limits<int>::max(); }
 
+    /**
+     * @brief frameRate Nominal frame rate of a recorded stream
+     * @return Frames per second, 0 if unknown
+     */
+    virtual double frameRate() const { return 0.0; }
+
+    /**
+     * @brief framePosition Stream time of the last captured frame
+     * @return The presentation time in seconds, negative if unknown
+     */
+    virtual double framePosition() const { return -1.0; }
+
+    /**
+     * @brief seek Seek a recorded stream to the given time
+     * @param seconds Stream time in seconds, the next captured frame is at or before this time
+     * @return false if the device does not support seeking
+     */
+    virtual bool seek(double seconds) { return false; }
+
     virtual std::string getDeviceId() const { return m_deviceID; }
 
 protected:
@@ -46,8 +46,13 @@ public:
         int dst_width;
         int dst_height;
         int numberOfFrames;
+        double fps = 0.0;
+        double frameTime = -1.0;
+        bool keyframesOnly = false;
+        bool grayscale = false;
         bool isOpened() const;
         bool seek(uint64_t frame);
+        bool seekTime(double seconds);
     };
 
 public:
@@ -65,6 +70,9 @@ public:
     std::string getDriver() { return "FFMPEG"; }
 
     virtual int numberOfFrames() const;
+    virtual double frameRate() const;
+    virtual double framePosition() const;
+    virtual bool seek(double seconds);
 
 private:
     bool openCamera(FFMPEGDeviceStream &vc, const std::string &ID);
@@ -6,7 +6,6 @@
 #include "Device.h"
 #include "librealsense2/rs.hpp"
 #include <mutex>
-#include <condition_variable>
 
 namespace DeviceFactory{
 class RealSense2Device : public Device
@@ -54,19 +53,21 @@ private:
     void imu_callback(const rs2::frame &frame);
     bool getDevice(const std::string serial, rs2::context &ctx, rs2::device &out_device);
 
-    rs2::frameset m_fsLast;
+    // Framesets waiting to be captured, the oldest is dropped when it is full. Frames stay in the SDK frame pool, a
+    // small queue keeps the latency low and the pool from running out while captures still reference their frames.
+    rs2::frame_queue m_frameQueue;
+    unsigned int m_queueSize;
 
     rs2::context m_ctx;
     rs2_stream m_align_to;
+    rs2_stream m_imageStream;
+    rs2_format m_imageFormat;
     rs2::align* m_align;
     rs2::pipeline_profile m_pipe_profile;
     rs2::device m_selected_device;
 
     std::mutex m_imu_mutex;
 
-
-    std::condition_variable m_cond_image_rec;
-
     //std::vector<double> m_v_accel_timestamp;
     //std::vector<rs2_vector> m_v_accel_data;
     //std::vector<double> m_v_gyro_timestamp;
@@ -82,7 +83,6 @@ private:
     std::vector<rs2_vector> m_v_accel_data_sync;
 
     double m_timestamp_image;
-    bool m_image_ready;
     int m_count_im_buffer; // count dropped frames
 
 
@@ -93,6 +93,8 @@ private:
     void setAutoWhiteBalance(const DeviceProperties &properties);
     void setWhiteBalance(const DeviceProperties &properties);
     void setExposure(const DeviceProperties& properties);
+    void setImageStream(const DeviceProperties& properties);
+    void setQueueSize(const DeviceProperties& properties);
 
 };
 
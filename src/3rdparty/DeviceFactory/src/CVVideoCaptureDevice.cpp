@@ -8,6 +8,7 @@ CVVideoCaptureDevice::CVVideoCaptureDevice()
 {
     m_framesInSequence = -1;
     m_frameID = 0;
+    m_grayscale = false;
 
 }
 
@@ -17,6 +18,9 @@ void CVVideoCaptureDevice::captureImages(cv::Mat &color, double &timestamp)
     if (m_videoCaptureColor.isOpened())
     {
         m_videoCaptureColor >> color;
+        // VideoCapture always decodes to BGR, convert once here so callers only see the single channel frame
+        if (m_grayscale && color.channels() == 3)
+            cv::cvtColor(color, color, cv::COLOR_BGR2GRAY);
         auto m_current = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(m_current - m_startTime);
         timestamp = duration.count()/1000.0;
@@ -173,6 +177,9 @@ bool CVVideoCaptureDevice::init(const std::string ID, const DeviceProperties &pr
     m_frameID = 0;
     setInitInfo(ID, properties, calibrationFile);
 
+    auto itGrayscale = properties.find("grayscale");
+    m_grayscale = itGrayscale != properties.end() && itGrayscale->second == "1";
+
     // Split ID string by seperator
     std::vector<std::string> subParts = split(ID, ';');
     for (int i = 0; i < subParts.size(); ++i)
@@ -259,6 +266,8 @@ void CVVideoCaptureDevice::listAvailableDevices()
 
     std::cout << "--------------------------------" << std::endl;
     std::cout << "<path to image file sequence> (e.g. img_%02d.jpg starting from 0)" << std::endl;
+    std::cout << "Device properties" << std::endl;
+    std::cout << "\t[\"grayscale\"] = \"1\" to return single channel frames for the RGB stream." << std::endl;
 }
 
 int CVVideoCaptureDevice::numberOfFrames() const
@@ -288,5 +297,32 @@ int CVVideoCaptureDevice::numberOfFrames() const
     }
     return std::numeric_limits<int>::max();
 }
+
+double CVVideoCaptureDevice::frameRate() const
+{
+    if (m_videoCaptureColor.isOpened())
+        return m_videoCaptureColor.get(cv::CAP_PROP_FPS);
+    else if (m_videoCaptureDepth.isOpened())
+        return m_videoCaptureDepth.get(cv::CAP_PROP_FPS);
+    return 0.0;
+}
+
+double CVVideoCaptureDevice::framePosition() const
+{
+    if (m_videoCaptureColor.isOpened())
+        return m_videoCaptureColor.get(cv::CAP_PROP_POS_MSEC) / 1000.0;
+    else if (m_videoCaptureDepth.isOpened())
+        return m_videoCaptureDepth.get(cv::CAP_PROP_POS_MSEC) / 1000.0;
+    return -1.0;
 }
 
+bool CVVideoCaptureDevice::seek(double seconds)
+{
+    bool ret = true;
+    if (m_videoCaptureColor.isOpened())
+        ret = ret && m_videoCaptureColor.set(cv::CAP_PROP_POS_MSEC, seconds * 1000.0);
+    if (m_videoCaptureDepth.isOpened())
+        ret = ret && m_videoCaptureDepth.set(cv::CAP_PROP_POS_MSEC, seconds * 1000.0);
+    return ret;
+}
+}
@@ -77,6 +77,10 @@ bool FFMPEGDevice::FFMPEGDeviceStream::open(const std::string &file)
 
     codecctx = codec_ctx; // store it for later use
 
+    // only decode intra frames, the decoder drops everything in between
+    if (keyframesOnly)
+        codecctx->skip_frame = AVDISCARD_NONKEY;
+
     // print info
     std::cout
         << "infile: " << infile << "\n"
@@ -90,11 +94,13 @@ bool FFMPEGDevice::FFMPEGDeviceStream::open(const std::string &file)
         << std::flush;
 
     numberOfFrames = vstrm->nb_frames;
+    fps = av_q2d(vstrm->avg_frame_rate);
 
     // setup scaler
     dst_width = codecctx->width;
     dst_height = codecctx->height;
-    const AVPixelFormat dst_pix_fmt = AV_PIX_FMT_BGR24;
+    // GRAY8 only takes the luma plane of YUV streams, no colour conversion is done
+    const AVPixelFormat dst_pix_fmt = grayscale ? AV_PIX_FMT_GRAY8 : AV_PIX_FMT_BGR24;
 
     swsctx = sws_getCachedContext(
         nullptr, codecctx->width, codecctx->height, codecctx->pix_fmt,
@@ -131,6 +137,20 @@ bool FFMPEGDevice::FFMPEGDeviceStream::seek(uint64_t frame)
     return true;
 }
 
+bool FFMPEGDevice::FFMPEGDeviceStream::seekTime(double seconds)
+{
+    int64_t seekTarget = static_cast<int64_t>(seconds / av_q2d(vstrm->time_base));
+    if (vstrm->start_time != AV_NOPTS_VALUE)
+        seekTarget += vstrm->start_time;
+
+    if (av_seek_frame(inctx, vstrm_idx, seekTarget, AVSEEK_FLAG_BACKWARD) < 0)
+        return false;
+
+    avcodec_flush_buffers(codecctx);
+    end_of_stream = false;
+    return true;
+}
+
 bool FFMPEGDevice::FFMPEGDeviceStream::isOpened() const
 {
     return (decframe != nullptr);
@@ -187,12 +207,24 @@ cv::Mat FFMPEGDevice::FFMPEGDeviceStream::getFrame()
         }
 
         // Frame successfully decoded
+        int64_t pts = decframe->best_effort_timestamp;
+        if (pts != AV_NOPTS_VALUE)
+        {
+            if (vstrm->start_time != AV_NOPTS_VALUE)
+                pts -= vstrm->start_time;
+            frameTime = pts * av_q2d(vstrm->time_base);
+        }
+        else if (fps > 0.0)
+        {
+            frameTime = nb_frames / fps;
+        }
+
         sws_scale(swsctx,
                   decframe->data, decframe->linesize,
                   0, decframe->height,
                   frame->data, frame->linesize);
 
-        cv::Mat image(dst_height, dst_width, CV_8UC3, framebuf.data(), frame->linesize[0]);
+        cv::Mat image(dst_height, dst_width, grayscale ? CV_8UC1 : CV_8UC3, framebuf.data(), frame->linesize[0]);
         result = image.clone();
 
         std::cout << nb_frames << '\r' << std::flush;
@@ -225,6 +257,7 @@ void FFMPEGDevice::FFMPEGDeviceStream::close()
     vstrm_idx = -1;
     end_of_stream = false;
     nb_frames = 0;
+    frameTime = -1.0;
 }
 
 
@@ -380,6 +413,15 @@ bool FFMPEGDevice::init(const std::string ID, const DeviceProperties &properties
 
     setInitInfo(ID, properties, calibrationFile);
 
+    auto itKeyframes = properties.find("keyframes");
+    bool keyframesOnly = itKeyframes != properties.end() && itKeyframes->second == "1";
+    m_videoCaptureColor.keyframesOnly = keyframesOnly;
+    m_videoCaptureDepth.keyframesOnly = keyframesOnly;
+
+    // Depth is packed in the colour channels, only the colour stream can be decoded to grayscale
+    auto itGrayscale = properties.find("grayscale");
+    m_videoCaptureColor.grayscale = itGrayscale != properties.end() && itGrayscale->second == "1";
+
     // Split ID string by seperator
     std::vector<std::string> subParts = split(ID, ';');
     for (int i = 0; i < subParts.size(); ++i)
@@ -474,6 +516,9 @@ void FFMPEGDevice::listAvailableDevices()
     std::cout << "<path to video file>#Depth (processes as Depth image)" << std::endl;
     std::cout << "<path to video file 1>#RGB;<path to video file 2>#Depth (two cameras, first as RGB, second as Depth - this assumes the same resolution)" << std::endl;
     std::cout << "<path to video file 1>#RGB;<path to video file 2>#Depth;<frames>#Frames (see above, #Frames defines the number of frames in the sequence)" << std::endl;
+    std::cout << "Device properties" << std::endl;
+    std::cout << "\t[\"keyframes\"] = \"1\" to only decode key frames." << std::endl;
+    std::cout << "\t[\"grayscale\"] = \"1\" to decode the RGB stream to single channel GRAY8 frames." << std::endl;
 
     std::cout << "--------------------------------" << std::endl;
 }
@@ -506,4 +551,32 @@ int FFMPEGDevice::numberOfFrames() const
     return std::numeric_limits<int>::max();
 }
 
+double FFMPEGDevice::frameRate() const
+{
+    if (m_videoCaptureColor.isOpened())
+        return m_videoCaptureColor.fps;
+    else if (m_videoCaptureDepth.isOpened())
+        return m_videoCaptureDepth.fps;
+    return 0.0;
+}
+
+double FFMPEGDevice::framePosition() const
+{
+    if (m_videoCaptureColor.isOpened())
+        return m_videoCaptureColor.frameTime;
+    else if (m_videoCaptureDepth.isOpened())
+        return m_videoCaptureDepth.frameTime;
+    return -1.0;
+}
+
+bool FFMPEGDevice::seek(double seconds)
+{
+    bool ret = true;
+    if (m_videoCaptureColor.isOpened())
+        ret = ret && m_videoCaptureColor.seekTime(seconds);
+    if (m_videoCaptureDepth.isOpened())
+        ret = ret && m_videoCaptureDepth.seekTime(seconds);
+    return ret;
+}
+
 }
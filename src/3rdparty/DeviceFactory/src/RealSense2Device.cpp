@@ -7,10 +7,64 @@
 #define WITH_IMU
 
 namespace DeviceFactory{
+
+namespace {
+// Lets a cv::Mat reference the data of a librealsense frame instead of a copy. The Mat holds a reference to the frame,
+// which goes back to the frame pool once the last Mat sharing its data is released.
+class FrameAllocator : public cv::MatAllocator
+{
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override
+    {
+        // A wrapped Mat that is created again with another size gets regular memory
+        return cv::Mat::getDefaultAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    bool allocate(cv::UMatData*, cv::AccessFlag, cv::UMatUsageFlags) const override
+    {
+        return false;
+    }
+
+    void deallocate(cv::UMatData* u) const override
+    {
+        if (!u)
+            return;
+
+        delete static_cast<rs2::frame*>(u->userdata);
+        delete u;
+    }
+
+    void unmap(cv::UMatData* u) const override
+    {
+        if (u->urefcount == 0 && u->refcount == 0)
+            deallocate(u);
+    }
+
+    cv::Mat wrap(const rs2::video_frame& frame, int type) const
+    {
+        cv::Mat mat(frame.get_height(), frame.get_width(), type, (void*)frame.get_data(), frame.get_stride_in_bytes());
+
+        cv::UMatData* u = new cv::UMatData(this);
+        u->data = u->origdata = mat.data;
+        u->size = mat.step[0] * mat.rows;
+        u->userdata = new rs2::frame(frame);
+        u->refcount = 1;
+
+        mat.allocator = this;
+        mat.u = u;
+        return mat;
+    }
+};
+
+const FrameAllocator frameAllocator;
+}
+
 RealSense2Device::RealSense2Device() : m_align(nullptr)
 {
+    m_imageStream = RS2_STREAM_COLOR;
+    m_imageFormat = RS2_FORMAT_BGR8;
+    m_queueSize = 1;
     m_timestamp_image = -1.0;
-    m_image_ready = false;
     m_count_im_buffer = 0;
 }
 
@@ -135,6 +189,9 @@ void RealSense2Device::listAvailableDevices()
         std::cout << "Device properties" << std::endl;
         std::cout << "\t[\"filename\"] = path to input/output file name. Empy to not defines for live streaming" << std::endl;
         std::cout << "\t[\"rw\"] = \"r\" for reading from file \"w\" for writing to file." << std::endl;
+        std::cout << "\t[\"grayscale\"] = \"1\" to stream YUYV and only return the luma of the color camera." << std::endl;
+        std::cout << "\t[\"infrared\"] = \"1\" to use the left Y8 infrared stream instead of the color camera." << std::endl;
+        std::cout << "\t[\"queue-size\"] = number of frames kept until they are captured, the oldest is dropped first. Defaults to 1, the latest frame." << std::endl;
 
 
     }
@@ -247,13 +304,11 @@ void RealSense2Device::imu_callback(const rs2::frame& frame)
         }
 
         //Align depth and rgb takes long time, move it out of the interruption to avoid losing IMU measurements
-        m_fsLast = fs;
+        m_frameQueue.enqueue(fs);
 
         m_timestamp_image = fs.get_timestamp() * 1e-3;
-        m_image_ready = true;
 
         lock.unlock();
-        m_cond_image_rec.notify_all();
         for (const auto &handler : handlers)
             handler(FRAME_DATA_TYPE::BGR_DEPTH, new_timestamp_image, 0.0f, 0.0f, 0.0f);
 
@@ -384,9 +439,47 @@ void RealSense2Device::setExposure(const DeviceProperties& properties)
     }
 }
 
+void RealSense2Device::setImageStream(const DeviceProperties& properties)
+{
+    m_imageStream = RS2_STREAM_COLOR;
+    m_imageFormat = RS2_FORMAT_BGR8;
+
+    auto itInfrared = properties.find("infrared");
+    if (itInfrared != properties.end() && itInfrared->second == "1")
+    {
+        m_imageStream = RS2_STREAM_INFRARED;
+        m_imageFormat = RS2_FORMAT_Y8;
+        return;
+    }
+
+    // YUYV is the native format of the color sensor, the Y channel is the grayscale image
+    auto itGrayscale = properties.find("grayscale");
+    if (itGrayscale != properties.end() && itGrayscale->second == "1")
+        m_imageFormat = RS2_FORMAT_YUYV;
+}
+
+void RealSense2Device::setQueueSize(const DeviceProperties& properties)
+{
+    m_queueSize = 1;
+
+    auto itInner = properties.find("queue-size");
+    if (itInner != properties.end())
+    {
+        std::istringstream iss(itInner->second);
+        iss >> m_queueSize;
+        if (m_queueSize < 1)
+            m_queueSize = 1;
+    }
+
+    // Frames are not kept out of the pool, the captures reference their memory directly
+    m_frameQueue = rs2::frame_queue(m_queueSize, false);
+}
+
 bool RealSense2Device::init(const std::string ID, const DeviceProperties& properties, const std::string& calibrationFile)
 {
     setInitInfo(ID, properties, calibrationFile);
+    setImageStream(properties);
+    setQueueSize(properties);
 
     // Read properties
     std::string filename;
@@ -422,7 +515,10 @@ bool RealSense2Device::init(const std::string ID, const DeviceProperties& proper
         }
 
         // RGB stream
-        cfg.enable_stream(RS2_STREAM_COLOR, 1280, 720, RS2_FORMAT_BGR8, 30);
+        if (m_imageStream == RS2_STREAM_INFRARED)
+            cfg.enable_stream(RS2_STREAM_INFRARED, 1, 1280, 720, m_imageFormat, 30);
+        else
+            cfg.enable_stream(RS2_STREAM_COLOR, 1280, 720, m_imageFormat, 30);
        // cfg.enable_stream(RS2_STREAM_COLOR, 640, 480, RS2_FORMAT_BGR8, 30);
 
         // Depth stream
@@ -495,7 +591,7 @@ bool RealSense2Device::init(const std::string ID, const DeviceProperties& proper
     rs2::playback playback = device.as<rs2::playback>();
     playback.set_real_time(false);*/
 
-    rs2::stream_profile cam_stream = m_pipe_profile.get_stream(RS2_STREAM_COLOR);
+    rs2::stream_profile cam_stream = m_pipe_profile.get_stream(m_imageStream);
     rs2_intrinsics intrinsics_cam = cam_stream.as<rs2::video_stream_profile>().get_intrinsics();
 
     int width_img = intrinsics_cam.width;
@@ -557,21 +653,16 @@ void RealSense2Device::captureImages(cv::Mat &color, double& timestamp)
 
 void RealSense2Device::captureImages(cv::Mat &color, cv::Mat &depth, double& timestamp)
 {
-    rs2::frameset fs;
+    rs2::frameset fs = m_frameQueue.wait_for_frame().as<rs2::frameset>();
+    timestamp = fs.get_timestamp() * 1e-3;
 
     {
         std::unique_lock<std::mutex> lk(m_imu_mutex);
-        if(!m_image_ready)
-            m_cond_image_rec.wait(lk);
 
-        fs = m_fsLast;
-
-        if(m_count_im_buffer>1)
-            std::cout << m_count_im_buffer -1 << " dropped frs\n";
+        // More framesets than the queue holds came in since the last capture
+        if(m_count_im_buffer>(int)m_queueSize)
+            std::cout << m_count_im_buffer - (int)m_queueSize << " dropped frs\n";
         m_count_im_buffer = 0;
-
-        timestamp = m_timestamp_image;
-        m_image_ready = false;
     }
 
     // Perform alignment here
@@ -581,11 +672,18 @@ void RealSense2Device::captureImages(cv::Mat &color, cv::Mat &depth, double& tim
     rs2::video_frame color_frame = processed.first(m_align_to);
     rs2::depth_frame depth_frame = processed.get_depth_frame();
 
-    int w = getWidth();
-    int h = getHeight();
-
-    color = cv::Mat(cv::Size(w, h), CV_8UC3, (void*)(color_frame.get_data()), cv::Mat::AUTO_STEP).clone();
-    depth = cv::Mat(cv::Size(w, h), CV_16U, (void*)(depth_frame.get_data()), cv::Mat::AUTO_STEP).clone();
+    // The images reference the frame memory, the frames are held until the caller releases them. They are read only.
+    if (color_frame.get_profile().format() == RS2_FORMAT_Y8)
+        color = frameAllocator.wrap(color_frame, CV_8UC1);
+    else if (color_frame.get_profile().format() == RS2_FORMAT_YUYV)
+    {
+        // The previous capture can still be referenced by the caller, do not convert into it
+        color.release();
+        cv::cvtColor(frameAllocator.wrap(color_frame, CV_8UC2), color, cv::COLOR_YUV2GRAY_YUY2);
+    }
+    else
+        color = frameAllocator.wrap(color_frame, CV_8UC3);
+    depth = frameAllocator.wrap(depth_frame, CV_16U);
 
 }
 
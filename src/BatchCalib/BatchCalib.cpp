@@ -0,0 +1,241 @@
+#include <iostream>
+#include <vector>
+#include <filesystem>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <opencv2/core.hpp>
+#include "CameraCalibrator.h"
+#include "MirrorCalibrator.h"
+#include "ProcamCalibrator.h"
+#include "Projector.h"
+#include "ThreadPool.h"
+#include "DetectorPool.h"
+#include "Config.h"
+#include "Utils.h"
+
+using namespace std;
+
+class CmdLineParser {
+
+private:
+    int argc; char** argv;
+
+public:
+    CmdLineParser(int _argc, char** _argv) :argc(_argc), argv(_argv) {}  bool operator[] (string param) { int idx = -1;  for (int i = 0; i < argc && idx == -1; i++) if (string(argv[i]) == param) idx = i;	return (idx != -1); } string operator()(string param, string defvalue = "") { int idx = -1;	for (int i = 0; i < argc && idx == -1; i++) if (string(argv[i]) == param) idx = i; if (idx == -1) return defvalue;   else  return (argv[idx + 1]); }
+};
+
+struct BatchJob
+{
+    std::string name;
+    std::string recording;
+    std::string patterns;
+    std::string mirrorRecording;
+
+    bool mirrored = false;
+
+    double camTime = 0.0;
+    double mirrorTime = 0.0;
+    double procamTime = 0.0;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+};
+
+static std::mutex logMutex;
+
+static void logJob(const BatchJob& job, const std::string& message)
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+    std::cout << "[BatchCalib] " << job.name << ": " << message << std::endl;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::vector<BatchJob> readManifest(const std::string& manifestPath)
+{
+    cv::FileStorage fs(manifestPath, cv::FileStorage::READ + cv::FileStorage::FORMAT_JSON);
+    if (!fs.isOpened())
+    {
+        cerr << "[BatchCalib] Error: Could not open the manifest " << manifestPath << endl;
+        exit(1);
+    }
+
+    std::vector<BatchJob> jobs;
+    for (const auto& node : fs["jobs"])
+    {
+        BatchJob job;
+        node["recording"] >> job.recording;
+        node["patterns"] >> job.patterns;
+        node["mirror"] >> job.mirrorRecording;
+        node["name"] >> job.name;
+
+        std::string seqName = std::filesystem::path(job.recording).filename().string();
+        if (job.name.empty())
+            job.name = seqName;
+        job.mirrored = !seqName.empty() && seqName[0] == 'S';
+
+        if (!std::filesystem::exists(job.recording) || !std::filesystem::exists(job.patterns))
+        {
+            cerr << "[BatchCalib] Job " << job.name << ": recording or patterns folder does not exist" << endl;
+            exit(1);
+        }
+
+        if (job.mirrored && !std::filesystem::exists(job.mirrorRecording))
+        {
+            cerr << "[BatchCalib] Job " << job.name << ": a mirrored recording (S...) needs an existing mirror recording" << endl;
+            exit(1);
+        }
+
+        for (const auto& other : jobs)
+        {
+            if (other.name == job.name)
+            {
+                cerr << "[BatchCalib] Job name " << job.name << " is used twice, set a unique \"name\" in the manifest" << endl;
+                exit(1);
+            }
+        }
+
+        jobs.push_back(job);
+    }
+
+    if (jobs.empty())
+    {
+        cerr << "[BatchCalib] No jobs in " << manifestPath << endl;
+        exit(1);
+    }
+
+    return jobs;
+}
+
+static void runProcam(BatchJob& job)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::string camCalibPath = Config::cameraCalibrationFolder + job.name + ".json";
+    Projector proj{ job.patterns };
+    ProcamCalibrator calibrator;
+    bool initialized = job.mirrored ?
+        calibrator.init(job.recording, Config::mirrorCalibrationFolder + job.name + ".json", &proj, camCalibPath) :
+        calibrator.init(job.recording, &proj, camCalibPath);
+    if (!initialized)
+        exit(1);
+    calibrator.setOutputName(job.name);
+    calibrator.calibrate(false);
+    if (!calibrator.saveToJSON())
+        exit(1);
+
+    job.procamTime = secondsSince(start);
+    job.end = std::chrono::steady_clock::now();
+    logJob(job, "done in " + std::to_string(secondsSince(job.start)) + "s");
+}
+
+static void runMirror(ThreadPool& pool, BatchJob& job)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    MirrorCalibrator calibrator;
+    calibrator.init(job.mirrorRecording, Config::cameraCalibrationFolder + job.name + ".json");
+    calibrator.calibrate(false);
+    if (!calibrator.saveToJSON())
+        exit(1);
+
+    job.mirrorTime = secondsSince(start);
+    logJob(job, "mirror calibrated in " + std::to_string(job.mirrorTime) + "s");
+
+    pool.submit([&job](int) { runProcam(job); });
+}
+
+static void runCamera(ThreadPool& pool, BatchJob& job)
+{
+    job.start = std::chrono::steady_clock::now();
+
+    CameraCalibrator calibrator;
+    calibrator.init(job.recording);
+    calibrator.setOutputName(job.name);
+    calibrator.calibrate(false);
+    if (!calibrator.saveToJSON())
+        exit(1);
+
+    job.camTime = secondsSince(job.start);
+    logJob(job, "camera calibrated in " + std::to_string(job.camTime) + "s");
+
+    if (job.mirrored)
+        pool.submit([&pool, &job](int) { runMirror(pool, job); });
+    else
+        pool.submit([&job](int) { runProcam(job); });
+}
+
+int main(int argc, char** argv)
+{
+    CmdLineParser cml(argc, argv);
+    if (argc < 2 || cml["-h"]) {
+        cerr << std::endl << "Usage: ./BatchCalib manifest [-threads n] [-preset]" << std::endl;
+        cerr << std::endl << "manifest: JSON file with a \"jobs\" list, every job has a \"recording\", \"patterns\" and for mirrored recordings (S...) a \"mirror\" recording. An optional \"name\" is used for the output files, it defaults to the recording folder name." << std::endl;
+        cerr << std::endl << "[-threads]: number of worker threads, defaults to the number of cores." << std::endl;
+        cerr << std::endl << "[-preset]: detection preset, realtime, default or precise. Defaults to default." << std::endl;
+        return 0;
+    }
+
+    DetectionPreset::Type preset;
+    if (!DetectionPreset::parse(cml("-preset", "default"), preset))
+        exit(1);
+    DetectorPool::global().setPreset(preset);
+
+    std::string manifestPath = argv[1];
+    std::vector<BatchJob> jobs = readManifest(manifestPath);
+
+    // Camera, mirror and procam calibration of a job run one after the other, the stages of different jobs are
+    // interleaved on the pool. The calibrators take their detectors from DetectorPool, so a stage reuses the detectors
+    // released by the stages before it.
+    ThreadPool pool{ std::stoi(cml("-threads", "0")) };
+
+    std::cout << "[BatchCalib] Running " << jobs.size() << " jobs on " << pool.size() << " threads" << std::endl;
+    auto start = std::chrono::steady_clock::now();
+
+    for (auto& job : jobs)
+    {
+        pool.submit([&pool, &job](int) { runCamera(pool, job); });
+    }
+    pool.wait();
+
+    double totalTime = secondsSince(start);
+
+    std::string manifestName = std::filesystem::path(manifestPath).stem().string();
+    const std::string reportPath = Config::batchFolder + manifestName + ".json";
+    Utils::verifyDirectories(reportPath);
+
+    cv::FileStorage fs{ reportPath, cv::FileStorage::WRITE + cv::FileStorage::FORMAT_JSON };
+    if (!fs.isOpened())
+    {
+        cerr << "[BatchCalib] Error: Could not open the report file " << reportPath << endl;
+        exit(1);
+    }
+
+    fs << "threads" << pool.size();
+    fs << "total_time" << totalTime;
+    fs << "jobs" << "[";
+    for (const auto& job : jobs)
+    {
+        fs << "{";
+        fs << "name" << job.name;
+        fs << "recording" << job.recording;
+        fs << "cam_calib" << Config::cameraCalibrationFolder + job.name + ".json";
+        if (job.mirrored)
+            fs << "mirror_calib" << Config::mirrorCalibrationFolder + job.name + ".json";
+        fs << "procam_calib" << Config::procamCalibrationFolder + job.name + ".json";
+        fs << "cam_time" << job.camTime;
+        fs << "mirror_time" << job.mirrorTime;
+        fs << "procam_time" << job.procamTime;
+        fs << "total_time" << std::chrono::duration<double>(job.end - job.start).count();
+        fs << "}";
+    }
+    fs << "]";
+    fs.release();
+
+    std::cout << "[BatchCalib] Calibrated " << jobs.size() << " jobs in " << totalTime << "s, report saved to " << reportPath << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+#include <opencv2/imgcodecs.hpp>
+#include "CalibProtocol.h"
+#include "Utils.h"
+
+using namespace std;
+
+class CmdLineParser {
+
+private:
+    int argc; char** argv;
+
+public:
+    CmdLineParser(int _argc, char** _argv) :argc(_argc), argv(_argv) {}  bool operator[] (string param) { int idx = -1;  for (int i = 0; i < argc && idx == -1; i++) if (string(argv[i]) == param) idx = i;	return (idx != -1); } string operator()(string param, string defvalue = "") { int idx = -1;	for (int i = 0; i < argc && idx == -1; i++) if (string(argv[i]) == param) idx = i; if (idx == -1) return defvalue;   else  return (argv[idx + 1]); }
+};
+
+static int connectTo(const std::string& socketPath)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) < 0)
+    {
+        cerr << "[CalibClient] Could not connect to " << socketPath << ": " << std::strerror(errno) << endl;
+        exit(1);
+    }
+    return fd;
+}
+
+// Sends a request and returns the response, exits when the daemon reports an error
+static cv::FileStorage request(int fd, const std::string& header, const std::vector<uchar>& payload = {})
+{
+    CalibMessage response;
+    if (!CalibProtocol::send(fd, header, payload.data(), payload.size()) || !CalibProtocol::receive(fd, response))
+    {
+        cerr << "[CalibClient] Connection to the daemon lost" << endl;
+        exit(1);
+    }
+
+    cv::FileStorage fs = CalibProtocol::parse(response.header);
+    if (!fs.isOpened() || (std::string)fs["status"] != "ok")
+    {
+        cerr << "[CalibClient] Daemon error: " << (fs.isOpened() ? (std::string)fs["message"] : response.header) << endl;
+        exit(1);
+    }
+    return fs;
+}
+
+int main(int argc, char** argv)
+{
+    CmdLineParser cml(argc, argv);
+    if ((argc < 3 && !cml["-shutdown"]) || cml["-h"]) {
+        cerr << std::endl << "Usage: ./CalibClient type recording [-socket path] [-camcalib] [-mirrorcalib] [-patterns] [-name] [-encoded] [-gray] [-shutdown]" << std::endl;
+        cerr << std::endl << "Streams the images of a recording to a running CalibDaemon and prints the progress and the result." << std::endl;
+        cerr << std::endl << "type: camera, mirror or procam." << std::endl;
+        cerr << std::endl << "recording: folder with the images to send, named like for the other tools (S..., F..., M...)." << std::endl;
+        cerr << std::endl << "[-camcalib]: camera calibration, needed for mirror and procam jobs. [-mirrorcalib]: mirror calibration for mirrored procam jobs." << std::endl;
+        cerr << std::endl << "[-patterns]: pattern folder for procam jobs, the images are divided evenly over the patterns." << std::endl;
+        cerr << std::endl << "[-name]: output name, defaults to the recording folder name." << std::endl;
+        cerr << std::endl << "[-encoded]: send the image files instead of raw pixels. [-gray]: send grayscale frames." << std::endl;
+        cerr << std::endl << "[-shutdown]: stop the daemon when done." << std::endl;
+        return 0;
+    }
+
+    int fd = connectTo(cml("-socket", CalibProtocol::defaultSocket));
+
+    if (argc >= 3 && argv[1][0] != '-')
+    {
+        std::string type = argv[1];
+        std::string recording = argv[2];
+
+        cv::FileStorage start = CalibProtocol::writer();
+        start << "cmd" << "start";
+        start << "type" << type;
+        start << "recording" << recording;
+        start << "name" << cml("-name");
+        start << "camcalib" << cml("-camcalib");
+        start << "mirrorcalib" << cml("-mirrorcalib");
+        start << "patterns" << cml("-patterns");
+        request(fd, start.releaseAndGetString());
+
+        std::vector<std::string> images = Utils::loadImages(recording);
+        int capPerPattern = 1;
+        if (type == "procam")
+        {
+            int nrPatterns = (int)Utils::loadImages(cml("-patterns")).size();
+            capPerPattern = std::max(1, (int)images.size() / std::max(1, nrPatterns));
+        }
+
+        for (int imgId = 0; imgId < (int)images.size(); ++imgId)
+        {
+            cv::FileStorage frame = CalibProtocol::writer();
+            frame << "cmd" << "frame";
+            frame << "pattern" << imgId / capPerPattern;
+
+            std::vector<uchar> payload;
+            bool packed = images[imgId].find('#') != std::string::npos;
+            if (cml["-encoded"] && !packed)
+            {
+                std::ifstream file(images[imgId], std::ios::binary);
+                payload.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+                frame << "encoding" << "encoded";
+                frame << "grayscale" << (int)cml["-gray"];
+            }
+            else
+            {
+                cv::Mat img = Utils::readImage(images[imgId], cml["-gray"]);
+                if (!img.isContinuous())
+                    img = img.clone();
+                payload.assign(img.data, img.data + img.total() * img.elemSize());
+                frame << "encoding" << "raw";
+                frame << "rows" << img.rows;
+                frame << "cols" << img.cols;
+                frame << "type" << img.type();
+            }
+
+            cv::FileStorage response = request(fd, frame.releaseAndGetString(), payload);
+            cout << "[CalibClient] Frame " << imgId << ": " << ((int)response["detected"] ? "detected" : "not detected") << ", " << (int)response["detections"] << " detections" << endl;
+        }
+
+        cv::FileStorage solve = CalibProtocol::writer();
+        solve << "cmd" << "solve";
+        cv::FileStorage result = request(fd, solve.releaseAndGetString());
+        cout << "[CalibClient] Solved " << type << " calibration with " << (int)result["detections"] << " detections, saved to " << (std::string)result["output"] << endl;
+    }
+
+    if (cml["-shutdown"])
+    {
+        cv::FileStorage shutdown = CalibProtocol::writer();
+        shutdown << "cmd" << "shutdown";
+        request(fd, shutdown.releaseAndGetString());
+    }
+
+    close(fd);
+
+    return 0;
+}
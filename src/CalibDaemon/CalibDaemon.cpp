@@ -0,0 +1,40 @@
+#include <iostream>
+#include "CalibServer.h"
+#include "DetectorPool.h"
+
+using namespace std;
+
+class CmdLineParser {
+
+private:
+    int argc; char** argv;
+
+public:
+    CmdLineParser(int _argc, char** _argv) :argc(_argc), argv(_argv) {}  bool operator[] (string param) { int idx = -1;  for (int i = 0; i < argc && idx == -1; i++) if (string(argv[i]) == param) idx = i;	return (idx != -1); } string operator()(string param, string defvalue = "") { int idx = -1;	for (int i = 0; i < argc && idx == -1; i++) if (string(argv[i]) == param) idx = i; if (idx == -1) return defvalue;   else  return (argv[idx + 1]); }
+};
+
+int main(int argc, char** argv)
+{
+    CmdLineParser cml(argc, argv);
+    if (cml["-h"]) {
+        cerr << std::endl << "Usage: ./CalibDaemon [-socket path]" << std::endl;
+        cerr << std::endl << "Keeps the calibrators loaded and accepts calibration jobs and frames on a Unix domain socket, see CalibClient for the protocol." << std::endl;
+        cerr << std::endl << "[-socket]: socket to listen on, defaults to " << CalibProtocol::defaultSocket << "." << std::endl;
+        cerr << std::endl << "[-preset]: detection preset, realtime, default or precise. Defaults to default." << std::endl;
+        return 0;
+    }
+
+    DetectionPreset::Type preset;
+    if (!DetectionPreset::parse(cml("-preset", "default"), preset))
+        exit(1);
+    DetectorPool::global().setPreset(preset);
+
+    CalibServer server;
+    if (!server.open(cml("-socket", CalibProtocol::defaultSocket)))
+        exit(1);
+
+    server.run();
+    server.close();
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "CalibProtocol.h"
+#include <sys/socket.h>
+#include <cerrno>
+#include <iostream>
+
+using namespace cv;
+
+static bool writeAll(int fd, const void* data, size_t size)
+{
+	const char* p = static_cast<const char*>(data);
+	while (size > 0)
+	{
+		ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		p += n;
+		size -= n;
+	}
+	return true;
+}
+
+static bool readAll(int fd, void* data, size_t size)
+{
+	char* p = static_cast<char*>(data);
+	while (size > 0)
+	{
+		ssize_t n = ::recv(fd, p, size, 0);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return false;
+		p += n;
+		size -= n;
+	}
+	return true;
+}
+
+static void putUint32(uchar* dst, uint32_t value)
+{
+	for (int i = 0; i < 4; ++i)
+		dst[i] = (uchar)(value >> (8 * i));
+}
+
+static uint32_t getUint32(const uchar* src)
+{
+	return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+bool CalibProtocol::send(int fd, const std::string& header, const uchar* payload, size_t payloadSize)
+{
+	uchar sizes[8];
+	putUint32(sizes, (uint32_t)header.size());
+	putUint32(sizes + 4, (uint32_t)payloadSize);
+
+	return writeAll(fd, sizes, sizeof(sizes)) && writeAll(fd, header.data(), header.size()) && (payloadSize == 0 || writeAll(fd, payload, payloadSize));
+}
+
+bool CalibProtocol::receive(int fd, CalibMessage& message)
+{
+	uchar sizes[8];
+	if (!readAll(fd, sizes, sizeof(sizes)))
+		return false;
+
+	uint32_t headerSize = getUint32(sizes);
+	uint32_t payloadSize = getUint32(sizes + 4);
+	if (headerSize > maxPayloadSize || payloadSize > maxPayloadSize)
+	{
+		std::cerr << "[CalibProtocol] Message of " << headerSize << " + " << payloadSize << " bytes is too large" << std::endl;
+		return false;
+	}
+
+	message.header.resize(headerSize);
+	message.payload.resize(payloadSize);
+
+	return readAll(fd, message.header.data(), headerSize) && readAll(fd, message.payload.data(), payloadSize);
+}
+
+FileStorage CalibProtocol::parse(const std::string& header)
+{
+	try
+	{
+		return FileStorage(header, FileStorage::READ + FileStorage::MEMORY + FileStorage::FORMAT_JSON);
+	}
+	catch (const cv::Exception& e)
+	{
+		std::cerr << "[CalibProtocol] Invalid message header: " << e.what() << std::endl;
+		return FileStorage();
+	}
+}
+
+FileStorage CalibProtocol::writer()
+{
+	return FileStorage(".json", FileStorage::WRITE + FileStorage::MEMORY + FileStorage::FORMAT_JSON);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+// A message on the daemon socket is a little endian uint32 header size and uint32 payload size, followed by
+// a JSON header and an optional binary payload (the pixels or the encoded image of a frame).
+struct CalibMessage
+{
+	std::string header;
+	std::vector<uchar> payload;
+};
+
+class CalibProtocol
+{
+public:
+	inline static const std::string defaultSocket = "/tmp/procamcalib.sock";
+	inline static const uint32_t maxPayloadSize = 256u << 20;
+
+	static bool send(int fd, const std::string& header, const uchar* payload = nullptr, size_t payloadSize = 0);
+	static bool receive(int fd, CalibMessage& message);
+
+	// JSON headers are read and written with cv::FileStorage in memory
+	static cv::FileStorage parse(const std::string& header);
+	static cv::FileStorage writer();
+};
+
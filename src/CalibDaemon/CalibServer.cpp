@@ -0,0 +1,363 @@
+#include "CalibServer.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <opencv2/imgcodecs.hpp>
+#include "Config.h"
+
+using namespace cv;
+
+// Projector reads the circle grid size from the _<width>_<height> suffix of the folder name
+static bool hasPatternSize(const std::string& patternFolder)
+{
+	auto isNumber = [](const std::string& s) { return !s.empty() && s.size() < 6 && std::all_of(s.begin(), s.end(), ::isdigit); };
+
+	size_t heightIdx = patternFolder.find_last_of('_');
+	if (heightIdx == std::string::npos || heightIdx == 0)
+		return false;
+	size_t widthIdx = patternFolder.find_last_of('_', heightIdx - 1);
+	if (widthIdx == std::string::npos)
+		return false;
+
+	return isNumber(patternFolder.substr(widthIdx + 1, heightIdx - widthIdx - 1)) && isNumber(patternFolder.substr(heightIdx + 1));
+}
+
+CalibServer::CalibServer(): serverFd{-1}, running{false}, jobProjector{nullptr}, frames{0}
+{
+}
+
+CalibServer::~CalibServer()
+{
+	close();
+}
+
+bool CalibServer::open(const std::string& socketPath)
+{
+	sockaddr_un address{};
+	if (socketPath.size() >= sizeof(address.sun_path))
+	{
+		std::cerr << "[CalibServer] Socket path " << socketPath << " is too long" << std::endl;
+		return false;
+	}
+
+	address.sun_family = AF_UNIX;
+	std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+	serverFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (serverFd < 0)
+	{
+		std::cerr << "[CalibServer] Error: Could not create socket: " << std::strerror(errno) << std::endl;
+		return false;
+	}
+
+	// A socket file left behind by a previous daemon blocks bind
+	unlink(socketPath.c_str());
+
+	if (bind(serverFd, (sockaddr*)&address, sizeof(address)) < 0 || listen(serverFd, 4) < 0)
+	{
+		std::cerr << "[CalibServer] Error: Could not listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+		::close(serverFd);
+		serverFd = -1;
+		return false;
+	}
+
+	this->socketPath = socketPath;
+	std::cout << "[CalibServer] Listening on " << socketPath << std::endl;
+	return true;
+}
+
+void CalibServer::run()
+{
+	running = true;
+	while (running)
+	{
+		int clientFd = accept(serverFd, nullptr, nullptr);
+		if (clientFd < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			std::cerr << "[CalibServer] Error: accept failed: " << std::strerror(errno) << std::endl;
+			break;
+		}
+
+		std::cout << "[CalibServer] Client connected" << std::endl;
+		serve(clientFd);
+		::close(clientFd);
+		std::cout << "[CalibServer] Client disconnected" << std::endl;
+	}
+}
+
+void CalibServer::close()
+{
+	if (serverFd < 0)
+		return;
+
+	::close(serverFd);
+	unlink(socketPath.c_str());
+	serverFd = -1;
+}
+
+void CalibServer::serve(int clientFd)
+{
+	CalibMessage message;
+	while (running && CalibProtocol::receive(clientFd, message))
+	{
+		if (!handle(clientFd, message))
+			break;
+	}
+}
+
+bool CalibServer::handle(int clientFd, const CalibMessage& message)
+{
+	FileStorage request = CalibProtocol::parse(message.header);
+	std::string cmd = request.isOpened() ? (std::string)request["cmd"] : "";
+
+	// A bad request fails that request, the daemon keeps serving the other clients
+	std::string response;
+	try
+	{
+		if (cmd == "start")
+			response = startJob(request);
+		else if (cmd == "frame")
+			response = addFrame(request, message.payload);
+		else if (cmd == "solve")
+			response = solve();
+		else if (cmd == "status")
+			response = status();
+		else if (cmd == "shutdown")
+		{
+			running = false;
+			response = status();
+		}
+		else
+			response = error("Unknown command '" + cmd + "'");
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "[CalibServer] Error: '" << cmd << "' failed: " << e.what() << std::endl;
+		response = error("'" + cmd + "' failed: " + e.what());
+	}
+
+	return CalibProtocol::send(clientFd, response);
+}
+
+std::string CalibServer::startJob(const FileStorage& request)
+{
+	std::string type = (std::string)request["type"];
+	std::string recording = (std::string)request["recording"];
+	std::string name = (std::string)request["name"];
+	std::string camCalib = (std::string)request["camcalib"];
+	std::string mirrorCalib = (std::string)request["mirrorcalib"];
+	std::string patterns = (std::string)request["patterns"];
+	std::string debugOutput = (std::string)request["dbgout"];
+
+	if (recording.empty())
+		return error("A job needs a recording name, it decides whether the frames are mirrored (S...) or which mirror calibration is used (F.../M...)");
+	if (name.empty())
+		name = std::filesystem::path(recording).filename().string();
+
+	char mode = std::filesystem::path(recording).filename().string()[0];
+	if (type == "mirror" && mode != 'F' && mode != 'M')
+		return error("Mirror recordings start with 'F' for full view or 'M' for real-virtual observations");
+	if (type != "camera" && !std::filesystem::exists(camCalib))
+		return error("Camera calibration '" + camCalib + "' does not exist");
+	if (type == "procam" && !mirrorCalib.empty() && !std::filesystem::exists(mirrorCalib))
+		return error("Mirror calibration '" + mirrorCalib + "' does not exist");
+	if (type == "procam" && !std::filesystem::exists(patterns))
+		return error("Patterns folder '" + patterns + "' does not exist");
+	if (type == "procam" && !hasPatternSize(patterns))
+		return error("Patterns folder '" + patterns + "' does not end in _<width>_<height>");
+
+	camCalibrator.reset();
+	mirrorCalibrator.reset();
+	procamCalibrator.reset();
+	jobProjector = nullptr;
+	jobType.clear();
+	frames = 0;
+
+	if (type == "camera")
+	{
+		camCalibrator = std::make_unique<CameraCalibrator>();
+		camCalibrator->init(recording);
+		camCalibrator->setOutputName(name);
+		if (!debugOutput.empty())
+			camCalibrator->setDebugOutput(debugOutput);
+	}
+	else if (type == "mirror")
+	{
+		mirrorCalibrator = std::make_unique<MirrorCalibrator>();
+		mirrorCalibrator->init(recording, camCalib);
+		if (!debugOutput.empty())
+			mirrorCalibrator->setDebugOutput(debugOutput);
+	}
+	else if (type == "procam")
+	{
+		// Patterns and their circle grids stay loaded for the next jobs with the same pattern set
+		auto& proj = projectors[patterns];
+		if (!proj)
+			proj = std::make_unique<Projector>(patterns);
+		if (proj->getNrPatterns() == 0)
+		{
+			projectors.erase(patterns);
+			return error("Patterns folder '" + patterns + "' has no patterns");
+		}
+		jobProjector = proj.get();
+
+		procamCalibrator = std::make_unique<ProcamCalibrator>();
+		bool initialized = mirrorCalib.empty() ?
+			procamCalibrator->init(recording, jobProjector, camCalib) :
+			procamCalibrator->init(recording, mirrorCalib, jobProjector, camCalib);
+		if (!initialized)
+		{
+			procamCalibrator.reset();
+			return error("Could not read the camera or mirror calibration of the job");
+		}
+		procamCalibrator->setOutputName(name);
+		if (!debugOutput.empty())
+			procamCalibrator->setDebugOutput(debugOutput);
+	}
+	else
+	{
+		return error("Unknown job type '" + type + "', use camera, mirror or procam");
+	}
+
+	jobType = type;
+	jobName = name;
+	camCalibName = camCalib;
+
+	std::cout << "[CalibServer] Started " << jobType << " job " << jobName << std::endl;
+	return status();
+}
+
+std::string CalibServer::addFrame(const FileStorage& request, const std::vector<uchar>& payload)
+{
+	if (jobType.empty())
+		return error("No job started");
+
+	Mat img;
+	std::string encoding = (std::string)request["encoding"];
+	if (encoding.empty() || encoding == "raw")
+	{
+		int rows = (int)request["rows"];
+		int cols = (int)request["cols"];
+		int type = (int)request["type"];
+		if (rows <= 0 || cols <= 0 || CV_MAT_DEPTH(type) != CV_8U || (size_t)rows * cols * CV_ELEM_SIZE(type) != payload.size())
+			return error("Raw frames need rows, cols and an 8 bit type matching the payload size");
+
+		// Detection is done before the next message overwrites the payload, no copy needed
+		img = Mat(rows, cols, type, const_cast<uchar*>(payload.data()));
+	}
+	else if (encoding == "encoded")
+	{
+		img = imdecode(payload, (int)request["grayscale"] ? IMREAD_GRAYSCALE : IMREAD_COLOR);
+		if (img.empty())
+			return error("Could not decode the frame");
+	}
+	else
+	{
+		return error("Unknown encoding '" + encoding + "', use raw or encoded");
+	}
+
+	bool detected = false;
+	if (camCalibrator)
+	{
+		detected = camCalibrator->addFrame(img);
+	}
+	else if (mirrorCalibrator)
+	{
+		detected = mirrorCalibrator->addFrame(img);
+	}
+	else if (procamCalibrator)
+	{
+		int patternId = (int)request["pattern"];
+		if (patternId < 0 || patternId >= jobProjector->getNrPatterns())
+			return error("Pattern " + std::to_string(patternId) + " does not exist");
+		detected = procamCalibrator->addFrame(patternId, img);
+	}
+	++frames;
+
+	FileStorage fs = CalibProtocol::writer();
+	fs << "status" << "ok";
+	fs << "detected" << (int)detected;
+	fs << "frames" << frames;
+	fs << "detections" << getDetections();
+	return fs.releaseAndGetString();
+}
+
+std::string CalibServer::solve()
+{
+	if (jobType.empty())
+		return error("No job started");
+
+	std::string output;
+	bool solved = false;
+	if (camCalibrator)
+	{
+		solved = camCalibrator->solve();
+		if (solved && !camCalibrator->saveToJSON())
+			return error("Could not write the calibration");
+		output = Config::cameraCalibrationFolder + jobName + ".json";
+	}
+	else if (mirrorCalibrator)
+	{
+		solved = mirrorCalibrator->solve();
+		if (solved && !mirrorCalibrator->saveToJSON())
+			return error("Could not write the calibration");
+		output = Config::mirrorCalibrationFolder + std::filesystem::path(camCalibName).filename().string();
+	}
+	else if (procamCalibrator)
+	{
+		solved = procamCalibrator->solve();
+		if (solved && !procamCalibrator->saveToJSON())
+			return error("Could not write the calibration");
+		output = Config::procamCalibrationFolder + jobName + ".json";
+	}
+
+	if (!solved)
+		return error("Could not solve the " + jobType + " calibration, see the daemon log");
+
+	FileStorage fs = CalibProtocol::writer();
+	fs << "status" << "ok";
+	fs << "job" << jobType;
+	fs << "name" << jobName;
+	fs << "detections" << getDetections();
+	fs << "output" << output;
+	return fs.releaseAndGetString();
+}
+
+std::string CalibServer::status()
+{
+	FileStorage fs = CalibProtocol::writer();
+	fs << "status" << "ok";
+	fs << "job" << jobType;
+	fs << "name" << jobName;
+	fs << "frames" << frames;
+	fs << "detections" << getDetections();
+	return fs.releaseAndGetString();
+}
+
+int CalibServer::getDetections() const
+{
+	if (camCalibrator)
+		return camCalibrator->getDetections();
+	if (mirrorCalibrator)
+		return mirrorCalibrator->getDetections();
+	if (procamCalibrator)
+		return procamCalibrator->getDetections();
+	return 0;
+}
+
+std::string CalibServer::error(const std::string& message)
+{
+	std::cerr << "[CalibServer] " << message << std::endl;
+
+	FileStorage fs = CalibProtocol::writer();
+	fs << "status" << "error";
+	fs << "message" << message;
+	return fs.releaseAndGetString();
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <string>
+#include "CalibProtocol.h"
+#include "CameraCalibrator.h"
+#include "MirrorCalibrator.h"
+#include "ProcamCalibrator.h"
+#include "Projector.h"
+
+// Keeps the calibrators resident between requests. Clients start a job (camera, mirror or procam), stream frames
+// and ask for a solve. The detectors (in DetectorPool) and the loaded patterns with their circle grids are kept for later jobs.
+// One client is served at a time.
+class CalibServer
+{
+private:
+	std::string socketPath;
+	int serverFd;
+	bool running;
+
+	std::map<std::string, std::unique_ptr<Projector>> projectors;
+
+	std::string jobType;
+	std::string jobName;
+	std::string camCalibName;
+	Projector* jobProjector;
+	int frames;
+	std::unique_ptr<CameraCalibrator> camCalibrator;
+	std::unique_ptr<MirrorCalibrator> mirrorCalibrator;
+	std::unique_ptr<ProcamCalibrator> procamCalibrator;
+
+	void serve(int clientFd);
+	bool handle(int clientFd, const CalibMessage& message);
+
+	std::string startJob(const cv::FileStorage& request);
+	std::string addFrame(const cv::FileStorage& request, const std::vector<uchar>& payload);
+	std::string solve();
+	std::string status();
+
+	int getDetections() const;
+	std::string error(const std::string& message);
+
+public:
+	CalibServer();
+	~CalibServer();
+
+	bool open(const std::string& socketPath);
+	void run();
+	void close();
+};
+
@@ -2,27 +2,67 @@
 #include "CameraCalibrator.h"
 #include "Utils.h"
 #include "Config.h"
+#include <algorithm>
 #include <filesystem>
+#include <numeric>
 
 using namespace cv;
 
 void CameraCalibrator::init()
 {
-	for (int i = 0; i < detector.getBoardSize().height; i++)
+	for (int i = 0; i < detector->getBoardSize().height; i++)
 	{
-		for (int j = 0; j < detector.getBoardSize().width; j++)
+		for (int j = 0; j < detector->getBoardSize().width; j++)
 		{
 			objp.push_back(Point3f{ (float)j * 4.43f, (float)i * 4.43f, 0.0f });
 		}
 	}
+
+	views.setBoard(0, objp);
+}
+
+int CameraCalibrator::loadCorrespondences()
+{
+	CorrespondenceStore store;
+	if (correspondenceFile.empty() || !store.open(correspondenceFile, { 3, 2 }))
+		return 0;
+
+	int nextId = 0;
+	for (int i = 0; i < store.size(); ++i)
+	{
+		nextId = std::max(nextId, store.getId(i) + 1);
+
+		frameSize = store.getFrameSize(i);
+		addView(store.getPoints(i, 0), store.getPoints(i, 1), frameSize);
+
+		// Saved views hold the whole board, in the order of its ids
+		std::vector<Point2f> corners = store.getPoints(i, 1);
+		std::vector<int> ids(corners.size());
+		std::iota(ids.begin(), ids.end(), 0);
+		autoCapture.accept(corners, ids);
+	}
+
+	std::cout << "[CameraCalibrator] Loaded " << store.size() << " views from " << correspondenceFile << std::endl;
+	return nextId;
+}
+
+void CameraCalibrator::addView(const Mat& boardPoints, const Mat& framePoints, const Size& frameSize)
+{
+	int slot = reservoir.offer(framePoints, frameSize);
+	if (slot < 0)
+		return;
+
+	views.store(slot, { boardPoints, framePoints });
 }
 
 void CameraCalibrator::calibrateInternal(Size camSize)
 {
+	reservoir.printSummary(std::cout);
+
 	Matx33d camInt;
 	std::vector<double> camDist;
 	Mat _rvecs, _tvecs;
-	float camRMS = calibrateCamera(objPoints, imgPoints, camSize, camInt, camDist, _rvecs, _tvecs);
+	camRMS = calibrateCamera(views.getSet(0), views.getSet(1), camSize, camInt, camDist, _rvecs, _tvecs);
 
 	std::cout << std::endl << "Camera RMS: " << camRMS << std::endl << "Intrinsics:" << std::endl << camInt << std::endl;
 
@@ -32,7 +72,7 @@ void CameraCalibrator::calibrateInternal(Size camSize)
 	camCalib.setHeight(camSize.height);
 }
 
-bool CameraCalibrator::detectAll(Mat img, bool mirrored, int debugDelay)
+bool CameraCalibrator::detectAll(int id, Mat img, bool mirrored, int debugDelay)
 {
 	if (debugDelay >= 0)
 	{
@@ -45,32 +85,52 @@ bool CameraCalibrator::detectAll(Mat img, bool mirrored, int debugDelay)
 	}
 
 	Mat gray;
-	cvtColor(img, gray, COLOR_BGR2GRAY);
+	Utils::toGray(img, gray);
 
+	// gray can share its data with img, do not flip in place
 	if (mirrored)
-		flip(gray, gray, 1);
+	{
+		Mat flipped;
+		flip(gray, flipped, 1);
+		gray = flipped;
+	}
 
 	std::vector<Point2f> corners;
 	std::vector<int> ids;
-	detector.detectCharucoCorners(gray, corners, ids);
+	detector->detectCharucoCorners(gray, corners, ids);
+
+	if (mirrored)
+	{
+		Utils::flip2dPoints(corners, gray.size().width);
+	}
 
+	return addDetection(id, img, corners, debugDelay);
+}
+
+bool CameraCalibrator::addDetection(int id, const Mat& img, const std::vector<Point2f>& corners, int debugDelay)
+{
 	if (corners.size() >= 35)
 	{
 		std::cout << "-- Charuco detected" << std::endl;
 
-		if (mirrored)
-		{
-			Utils::flip2dPoints(corners, gray.size().width);
-		}
+		addView(Mat(objp), Mat(corners), img.size());
+
+		if (correspondenceWriter.isOpened())
+			correspondenceWriter.write(id, img.size(), { Mat(objp), Mat(corners) });
 
-		objPoints.push_back(objp);
-		imgPoints.push_back(corners);
+		debugSink.submit("detected", img, { DebugOverlay::corners(detector->getBoardSize(), corners) });
 
 		if (debugDelay >= 0)
 		{
-			drawChessboardCorners(img, detector.getBoardSize(), corners, true);
-
-			imshow("Camera", img);
+			// img can be a read only frame of a packed recording
+			Mat shown;
+			if (img.channels() == 1)
+				cvtColor(img, shown, COLOR_GRAY2BGR);
+			else
+				shown = img.clone();
+			drawChessboardCorners(shown, detector->getBoardSize(), corners, true);
+
+			imshow("Camera", shown);
 			if (waitKey(debugDelay) == 'q')
 			{
 				destroyAllWindows();
@@ -83,12 +143,43 @@ bool CameraCalibrator::detectAll(Mat img, bool mirrored, int debugDelay)
 	else
 	{
 		std::cout << "!!!! Failed to find charuco board !!!!" << std::endl;
+		debugSink.submit("failed", img);
 		return false;
 	}
 }
 
-CameraCalibrator::CameraCalibrator()
+void CameraCalibrator::previewCorners(const Mat& img, bool mirrored, std::vector<Point2f>& corners, std::vector<int>& ids)
 {
+	if (tracker)
+	{
+		tracker->track(img, mirrored);
+		corners = tracker->getCorners();
+		ids = tracker->getIds();
+	}
+	else
+	{
+		Mat gray;
+		Utils::toGray(img, gray);
+		if (mirrored)
+		{
+			Mat flipped;
+			flip(gray, flipped, 1);
+			gray = flipped;
+		}
+		detector->detectCharucoCorners(gray, corners, ids);
+	}
+
+	if (mirrored)
+		Utils::flip2dPoints(corners, img.cols);
+}
+
+CameraCalibrator::CameraCalibrator(): detector{DetectorPool::global().acquireCharucoDetector()}, views{ { 3, 2 } }, camRMS{0}, packCaptures{false}, grayscale{false}
+{
+}
+
+void CameraCalibrator::setDetector(std::shared_ptr<CharucoDetector> detector)
+{
+	this->detector = detector;
 }
 
 void CameraCalibrator::init(const std::string& imgsFolder)
@@ -97,6 +188,54 @@ void CameraCalibrator::init(const std::string& imgsFolder)
 	init();
 }
 
+void CameraCalibrator::setPackCaptures(bool packCaptures)
+{
+	this->packCaptures = packCaptures;
+}
+
+bool CameraCalibrator::setCaptureFormat(const std::string& format, int compression)
+{
+	return archiver.setFormat(format, compression);
+}
+
+void CameraCalibrator::setGrayscale(bool grayscale)
+{
+	this->grayscale = grayscale;
+}
+
+void CameraCalibrator::setDebugOutput(const std::string& output)
+{
+	debugSink.open(output);
+}
+
+void CameraCalibrator::setTracking(bool tracking)
+{
+	if (tracking)
+		tracker = std::make_unique<CharucoTracker>(detector);
+	else
+		tracker.reset();
+}
+
+void CameraCalibrator::setMaxViews(int maxViews)
+{
+	reservoir.setCapacity(maxViews);
+}
+
+void CameraCalibrator::setMinNovelty(double minNovelty)
+{
+	autoCapture.setMinNovelty(minNovelty);
+}
+
+void CameraCalibrator::setOutputName(const std::string& outputName)
+{
+	this->outputName = outputName;
+}
+
+void CameraCalibrator::setCorrespondenceFile(const std::string& fileName)
+{
+	correspondenceFile = fileName;
+}
+
 void CameraCalibrator::calibrate(bool debug)
 {
 	bool mirrored = false;
@@ -109,7 +248,16 @@ void CameraCalibrator::calibrate(bool debug)
 	if (debug)
 		debugDelay = 0;
 
-	Mat refImg;
+	// The detections of an earlier run are solved again without reading the images
+	if (loadCorrespondences() > 0)
+	{
+		calibrateInternal(frameSize);
+		return;
+	}
+
+	if (!correspondenceFile.empty())
+		correspondenceWriter.open(correspondenceFile, { 3, 2 });
+
 	int imgId = -1;
 
 	int detections = 0;
@@ -118,23 +266,26 @@ void CameraCalibrator::calibrate(bool debug)
 	{
 		++imgId;
 
-		Mat img = imread(entry);
+		Mat img = Utils::readImage(entry, grayscale);
 		if (imgId == 0)
-			refImg = img;
+			frameSize = img.size();
 
 		//GaussianBlur(img, img, Size(3, 3), 1);
 
 		std::cout << "Loaded image " << imgId << std::endl;
 
-		if (detectAll(img, mirrored, debugDelay))
+		if (detectAll(imgId, img, mirrored, debugDelay))
 			++detections;
 	}
 
-	destroyAllWindows();
+	if (debug)
+		destroyAllWindows();
+
+	correspondenceWriter.close();
 
 	std::cout << "==== Number detections: " << detections << std::endl;
 
-	calibrateInternal(refImg.size());
+	calibrateInternal(frameSize);
 }
 
 void CameraCalibrator::calibrate(std::shared_ptr<DeviceFactory::Device> cam, int patterns)
@@ -145,48 +296,210 @@ void CameraCalibrator::calibrate(std::shared_ptr<DeviceFactory::Device> cam, int
 		mirrored = true;
 	}
 
-	int imgId = 0;
-	Mat refImg;
+	// An interrupted session continues after the captures it already has
+	int imgId = loadCorrespondences();
+	if (!correspondenceFile.empty())
+		correspondenceWriter.open(correspondenceFile, { 3, 2 }, true);
+
+	if (!archiver.open(imgsFolder, packCaptures, imgId > 0))
+	{
+		std::cerr << "[CameraCalibrator] Error: Could not open " << imgsFolder << " for the captures" << std::endl;
+		exit(1);
+	}
 
 	while (imgId < patterns)
 	{
 		Mat cap; double timestamp;
 		cam->captureImages(cap, timestamp);
 
-		Mat img = cap.clone();
-		Mat sImg = img.clone();
+		// Preview frames are only read, a copy is made for the frames that are detected and drawn on
+		const Mat& img = cap;
 
-		if (imgId == 0)
-			refImg = img;
+		if (frameSize.empty())
+			frameSize = img.size();
 
-		std::cout << "Trying new image..\n";
+		imshow("Camera", img);
+		if (waitKey(1) == 'q')
+		{
+			destroyAllWindows();
+			exit(1);
+		}
 
-		bool detected = detectAll(img, mirrored, 2000);
+		// The full detection only runs once the whole board is in view, holds still and adds a new view
+		std::vector<Point2f> corners;
+		std::vector<int> ids;
+		previewCorners(img, mirrored, corners, ids);
+		if (corners.size() < 35)
+		{
+			autoCapture.reset();
+			continue;
+		}
+		if (!autoCapture.update(corners, ids, img.size()))
+			continue;
+
+		std::cout << "Trying new image (novelty " << autoCapture.getNovelty() << ")..\n";
+
+		// A full detection of this frame by the tracker is not repeated, tracked corners are detected again
+		bool detected = tracker && tracker->isDetection() ? addDetection(imgId, img, corners, 1) : detectAll(imgId, img, mirrored, 1);
 		if (detected)
 		{
-			std::stringstream ss;
-			ss << std::setfill('0') << std::setw(2) << imgId << ".png";
-			Utils::verifyDirectories(imgsFolder + "/" + ss.str());
-			imwrite(imgsFolder + "/" + ss.str(), sImg);
+			autoCapture.accept(corners, ids);
+			if (tracker)
+				tracker->reset();
+
+			archiver.submit(imgId, cap);
 			++imgId;
 		}
 	}
 
+	archiver.close();
+	correspondenceWriter.close();
 	destroyAllWindows();
 
-	calibrateInternal(refImg.size()); 	
+	calibrateInternal(frameSize);
 }
 
-void CameraCalibrator::saveToJSON()
+void CameraCalibrator::calibrate(VideoFrameSource& video, bool debug)
+{
+	bool mirrored = false;
+	if (std::filesystem::path(imgsFolder).filename().string()[0] == 'S')
+	{
+		mirrored = true;
+	}
+
+	int debugDelay = -1;
+	if (debug)
+		debugDelay = 0;
+
+	if (loadCorrespondences() > 0)
+	{
+		calibrateInternal(frameSize);
+		return;
+	}
+
+	if (!correspondenceFile.empty())
+		correspondenceWriter.open(correspondenceFile, { 3, 2 });
+
+	int frameId = -1;
+	int detections = 0;
+	Size camSize;
+	Mat img;
+
+	while (video.next(img))
+	{
+		++frameId;
+
+		if (camSize.empty())
+			camSize = img.size();
+
+		std::cout << "Loaded frame " << frameId << " at " << video.getFrameTime() << "s" << std::endl;
+
+		if (detectAll(frameId, img, mirrored, debugDelay))
+			++detections;
+	}
+
+	destroyAllWindows();
+	correspondenceWriter.close();
+
+	std::cout << "==== Number detections: " << detections << std::endl;
+
+	if (detections == 0)
+	{
+		std::cerr << "[CameraCalibrator] No detections in video, aborting.." << std::endl;
+		exit(1);
+	}
+
+	calibrateInternal(camSize);
+}
+
+bool CameraCalibrator::addFrame(const Mat& img)
+{
+	bool mirrored = std::filesystem::path(imgsFolder).filename().string()[0] == 'S';
+
+	if (frameSize.empty())
+		frameSize = img.size();
+
+	return detectAll(reservoir.getSeen(), img, mirrored);
+}
+
+bool CameraCalibrator::solve()
+{
+	if (views.empty())
+	{
+		std::cerr << "[CameraCalibrator] No detections to calibrate with" << std::endl;
+		return false;
+	}
+
+	// Degenerate views make calibrateCamera throw, the daemon reports that instead of terminating
+	try
+	{
+		calibrateInternal(frameSize);
+	}
+	catch (const cv::Exception& e)
+	{
+		std::cerr << "[CameraCalibrator] Error: Calibration failed: " << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+int CameraCalibrator::getDetections() const
+{
+	return (int)reservoir.getSeen();
+}
+
+float CameraCalibrator::getRMS() const
+{
+	return camRMS;
+}
+
+void CameraCalibrator::estimateUncertainty(Uncertainty::Method method, int resamples)
+{
+	Matx33d fullInt = camCalib.getIntrinsicsMatrix();
+	std::vector<double> fullDist = camCalib.getDistortionParameters();
+	Size camSize(camCalib.getWidth(), camCalib.getHeight());
+
+	std::vector<double> stds = Uncertainty::estimate(method, views.size(), resamples, [&](const std::vector<int>& sample)
+	{
+		// Warm started from the solution of all views
+		Matx33d camInt = fullInt;
+		std::vector<double> camDist = fullDist;
+		Mat _rvecs, _tvecs;
+		calibrateCamera(views.getSet(0, sample), views.getSet(1, sample), camSize, camInt, camDist, _rvecs, _tvecs, CALIB_USE_INTRINSIC_GUESS);
+
+		std::vector<double> params{ camInt(0, 0), camInt(1, 1), camInt(0, 2), camInt(1, 2) };
+		params.insert(params.end(), camDist.begin(), camDist.end());
+		return params;
+	});
+
+	if (stds.empty())
+	{
+		std::cerr << "[CameraCalibrator] Not enough views to estimate the uncertainty" << std::endl;
+		return;
+	}
+
+	camIntStd = Matx33d::zeros();
+	camIntStd(0, 0) = stds[0];
+	camIntStd(1, 1) = stds[1];
+	camIntStd(0, 2) = stds[2];
+	camIntStd(1, 2) = stds[3];
+	camDistStd.assign(stds.begin() + 4, stds.end());
+
+	std::cout << "Intrinsics std:" << std::endl << camIntStd << std::endl;
+}
+
+bool CameraCalibrator::saveToJSON()
 {
 	std::string seqName = std::filesystem::path(imgsFolder).filename().string();
+	if (!outputName.empty())
+		seqName = outputName;
 	std::string filePath = Config::cameraCalibrationFolder + "/" + seqName + ".json";
 	Utils::verifyDirectories(filePath);
     cv::FileStorage fs{ filePath, cv::FileStorage::WRITE + cv::FileStorage::FORMAT_JSON };
     if (!fs.isOpened())
     {
         std::cerr << "[CameraCalibration] Error: Could not open the input file " << filePath << std::endl;
-        exit(1);
+        return false;
     }
 
     fs << "cam_width" << camCalib.getWidth();
@@ -194,5 +507,11 @@ void CameraCalibrator::saveToJSON()
     fs << "cam_int" << camCalib.getIntrinsicsMatrix();
     fs << "cam_dist" << camCalib.getDistortionParameters();
     fs << "cam_fisheye" << camCalib.isFishEye();
+    if (!camDistStd.empty())
+    {
+        fs << "cam_int_std" << camIntStd;
+        fs << "cam_dist_std" << camDistStd;
+    }
     fs.release();
+    return true;
 }
@@ -2,35 +2,106 @@
 #include <string>
 #include <vector>
 #include "CharucoDetector.h"
+#include "DetectorPool.h"
 #include "MirrorPlane.h"
 #include "DeviceFactory/CameraCalibration.h"
 #include "DeviceFactory/Device.h"
+#include "VideoFrameSource.h"
+#include "FrameArchiver.h"
+#include "DebugSink.h"
+#include "CharucoTracker.h"
+#include "CorrespondenceStore.h"
+#include "Uncertainty.h"
+#include "ViewReservoir.h"
+#include "CorrespondenceArena.h"
+#include "AutoCapture.h"
 
 class CameraCalibrator
 {
 private:
 	std::string imgsFolder;
+	std::string outputName;
 
-	CharucoDetector detector;
+	std::shared_ptr<CharucoDetector> detector;
 	CameraCalibration camCalib;
 
-	std::vector<std::vector<cv::Point2f>> imgPoints;
-	std::vector<std::vector<cv::Point3f>> objPoints;
+	// Board and image points of every view, views with the whole board share objp
+	CorrespondenceArena views;
+
+	// Picks the views that are kept when their number is capped
+	ViewReservoir reservoir;
 
 	std::vector<cv::Point3f> objp;
+	cv::Size frameSize;
+	float camRMS;
+
+	// Only filled by estimateUncertainty
+	cv::Matx33d camIntStd;
+	std::vector<double> camDistStd;
+
+	bool packCaptures;
+	FrameArchiver archiver;
+
+	bool grayscale;
+
+	DebugSink debugSink;
+
+	// Only set in tracking mode
+	std::unique_ptr<CharucoTracker> tracker;
+
+	// Live captures are taken once the board holds still in a view that adds coverage
+	AutoCapture autoCapture;
+
+	// Board and image points of every detection
+	std::string correspondenceFile;
+	CorrespondenceWriter correspondenceWriter;
 
 	void init();
+	// Returns the capture id after the last stored view, 0 without stored views
+	int loadCorrespondences();
+	void addView(const cv::Mat& boardPoints, const cv::Mat& framePoints, const cv::Size& frameSize);
 	void calibrateInternal(cv::Size camSize);
 
-	bool detectAll(cv::Mat img, bool mirrored, int debug = -1);
+	// The id of the image or frame is saved with the correspondences of a detection
+	bool detectAll(int id, cv::Mat img, bool mirrored, int debug = -1);
+	// Adds the corners of a detection, in the frame as it is, when they cover the whole board
+	bool addDetection(int id, const cv::Mat& img, const std::vector<cv::Point2f>& corners, int debug = -1);
+	void previewCorners(const cv::Mat& img, bool mirrored, std::vector<cv::Point2f>& corners, std::vector<int>& ids);
 
 public:
 	CameraCalibrator();
 
+	// Shares a detector between calibrators that run one after the other, call before init
+	void setDetector(std::shared_ptr<CharucoDetector> detector);
 	void init(const std::string& imgsFolder);
+	void setPackCaptures(bool packCaptures);
+	// Image format and PNG compression level of the live captures, see FrameArchiver::setFormat
+	bool setCaptureFormat(const std::string& format, int compression);
+	void setGrayscale(bool grayscale);
+	void setDebugOutput(const std::string& output);
+	void setTracking(bool tracking);
+	// At most maxViews views are kept in memory and solved, balanced over the image. 0 keeps every view.
+	void setMaxViews(int maxViews);
+	// Minimum mean corner distance of a live capture to every earlier capture, relative to the image diagonal
+	void setMinNovelty(double minNovelty);
+	void setOutputName(const std::string& outputName);
+
+	// Detections are saved to the file, and read from it instead of detected again when it exists
+	void setCorrespondenceFile(const std::string& fileName);
 
 	void calibrate(bool debug = false);
 	void calibrate(std::shared_ptr<DeviceFactory::Device> cam, int nrPatterns);
-	void saveToJSON();
+	void calibrate(VideoFrameSource& video, bool debug = false);
+
+	// Frame by frame calibration for frames that are not read from a recording
+	bool addFrame(const cv::Mat& img);
+	bool solve();
+	int getDetections() const;
+	float getRMS() const;
+
+	// Standard deviations of the intrinsics from resamples of the views, call after calibrate
+	void estimateUncertainty(Uncertainty::Method method, int resamples = 100);
+
+	bool saveToJSON();
 };
 
@@ -0,0 +1,157 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <opencv2/core.hpp>
+#include "CameraCalibrator.h"
+#include "ProcamCalibrator.h"
+#include "Projector.h"
+#include "DetectorPool.h"
+#include "Utils.h"
+
+using namespace std;
+
+class CmdLineParser {
+
+private:
+    int argc; char** argv;
+
+public:
+    CmdLineParser(int _argc, char** _argv) :argc(_argc), argv(_argv) {}  bool operator[] (string param) { int idx = -1;  for (int i = 0; i < argc && idx == -1; i++) if (string(argv[i]) == param) idx = i;	return (idx != -1); } string operator()(string param, string defvalue = "") { int idx = -1;	for (int i = 0; i < argc && idx == -1; i++) if (string(argv[i]) == param) idx = i; if (idx == -1) return defvalue;   else  return (argv[idx + 1]); }
+};
+
+struct BenchmarkRow
+{
+    std::string preset;
+    std::string stage;
+    int frames = 0;
+    int detections = 0;
+    double msPerFrame = 0.0;
+    std::string rms;
+};
+
+int main(int argc, char** argv)
+{
+    CmdLineParser cml(argc, argv);
+    if (argc < 2 || cml["-h"]) {
+        cerr << std::endl << "Usage: ./DetectionBenchmark recording [-patterns] [-camcalib] [-mirrorcalib] [-presets realtime,default,precise] [-gray] [-o table.md]" << std::endl;
+        cerr << std::endl << "Runs the camera calibration, and the procam calibration when patterns and a camera calibration are given, of a recording with every detection preset." << std::endl;
+        cerr << std::endl << "Prints the detection time per frame, the detection rate and the RMS of every preset as a markdown table." << std::endl;
+        cerr << std::endl << "recording: folder containing the recording. Starts with 'S' if recording is mirrored." << std::endl;
+        cerr << std::endl << "[-patterns] [-camcalib] [-mirrorcalib]: same as for ProcamCalib." << std::endl;
+        cerr << std::endl << "[-presets]: comma separated presets to compare, defaults to all." << std::endl;
+        cerr << std::endl << "[-gray]: load the frames as grayscale." << std::endl;
+        cerr << std::endl << "[-o]: also write the table to this file." << std::endl;
+        return 0;
+    }
+
+    std::string recordingFolder = argv[1];
+    std::string seqName = std::filesystem::path(recordingFolder).filename().string();
+    bool benchmarkProcam = cml["-patterns"] && cml["-camcalib"];
+    if (benchmarkProcam && seqName[0] == 'S' && !cml["-mirrorcalib"])
+    {
+        cerr << "[DetectionBenchmark] Mirror calibration [-mirrorcalib] should be specified when using a mirrored recording (S...)" << endl;
+        exit(1);
+    }
+
+    std::vector<DetectionPreset::Type> presets;
+    std::stringstream presetNames(cml("-presets", "realtime,default,precise"));
+    std::string presetName;
+    while (std::getline(presetNames, presetName, ','))
+    {
+        DetectionPreset::Type preset;
+        if (!DetectionPreset::parse(presetName, preset))
+            exit(1);
+        presets.push_back(preset);
+    }
+
+    // Frames are loaded once so the timings only contain detection
+    std::vector<cv::Mat> frames;
+    for (const auto& entry : Utils::loadImages(recordingFolder))
+        frames.push_back(Utils::readImage(entry, cml["-gray"]));
+
+    if (frames.empty())
+    {
+        cerr << "[DetectionBenchmark] No images found in " << recordingFolder << endl;
+        exit(1);
+    }
+
+    std::vector<BenchmarkRow> rows;
+    for (auto preset : presets)
+    {
+        DetectorPool::global().setPreset(preset);
+
+        {
+            CameraCalibrator calibrator;
+            calibrator.init(recordingFolder);
+
+            BenchmarkRow row;
+            row.preset = DetectionPreset::name(preset);
+            row.stage = "camera";
+
+            auto start = std::chrono::steady_clock::now();
+            for (const auto& frame : frames)
+                calibrator.addFrame(frame);
+            row.msPerFrame = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames.size();
+
+            row.frames = (int)frames.size();
+            row.detections = calibrator.getDetections();
+            row.rms = calibrator.solve() ? std::to_string(calibrator.getRMS()) : "-";
+            rows.push_back(row);
+        }
+
+        if (benchmarkProcam)
+        {
+            // A new projector, so the circle grids of the patterns are detected with this preset too
+            Projector proj{ cml("-patterns") };
+            ProcamCalibrator calibrator;
+            bool initialized = cml["-mirrorcalib"] ?
+                calibrator.init(recordingFolder, cml("-mirrorcalib"), &proj, cml("-camcalib")) :
+                calibrator.init(recordingFolder, &proj, cml("-camcalib"));
+            if (!initialized)
+                exit(1);
+
+            BenchmarkRow row;
+            row.preset = DetectionPreset::name(preset);
+            row.stage = "procam";
+
+            int capPerPattern = std::max(1, (int)frames.size() / proj.getNrPatterns());
+            auto start = std::chrono::steady_clock::now();
+            for (int imgId = 0; imgId < (int)frames.size(); ++imgId)
+                calibrator.addFrame(std::min(imgId / capPerPattern, proj.getNrPatterns() - 1), frames[imgId]);
+            row.msPerFrame = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames.size();
+
+            row.frames = (int)frames.size();
+            row.detections = calibrator.getDetections();
+            if (calibrator.solve())
+                row.rms = std::to_string(calibrator.getProjectorRMS()) + " / " + std::to_string(calibrator.getStereoRMS());
+            else
+                row.rms = "-";
+            rows.push_back(row);
+        }
+    }
+
+    std::stringstream table;
+    table << "| Preset | Stage | Frames | Detections | Detection rate | ms/frame | RMS (camera, or projector / stereo) |" << std::endl;
+    table << "| --- | --- | --- | --- | --- | --- | --- |" << std::endl;
+    for (const auto& row : rows)
+    {
+        table << "| " << row.preset << " | " << row.stage << " | " << row.frames << " | " << row.detections << " | "
+            << std::fixed << std::setprecision(1) << 100.0 * row.detections / row.frames << "% | "
+            << std::setprecision(2) << row.msPerFrame << " | " << row.rms << " |" << std::endl;
+    }
+
+    std::cout << std::endl << "[DetectionBenchmark] " << seqName << std::endl << table.str();
+
+    if (cml["-o"])
+    {
+        std::ofstream file(cml("-o"));
+        file << table.str();
+    }
+
+    return 0;
+}
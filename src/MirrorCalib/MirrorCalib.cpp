@@ -1,6 +1,7 @@
 #include <iostream>
 #include <vector>
 #include "MirrorCalibrator.h"
+#include "DetectorPool.h"
 #include "DeviceFactory/DeviceFactory.h"
 
 using namespace std;
@@ -35,21 +36,69 @@ int main(int argc, char** argv)
         cerr << std::endl << "calibPath: path to camera calibration data." << std::endl;
         cerr << std::endl << "[-p]: captures per pattern, only use when physical camera is connected." << std::endl;
         cerr << std::endl << "[-camid]: camera id to use. Only use when physical camera is connected." << std::endl;
+        cerr << std::endl << "[-gray]: decode images, video frames and camera captures directly to grayscale." << std::endl;
+        cerr << std::endl << "[-pack]: save captures to a single packed recording file instead of separate images. Only use when physical camera is connected." << std::endl;
+        cerr << std::endl << "[-format]: image format of the captures, png, bmp or tiff. Defaults to png. [-compression]: PNG compression level from 0 to 9, defaults to 1. Neither applies to [-pack], packed captures are stored raw. Captures are written in the background." << std::endl;
+        cerr << std::endl << "[-video]: video file to calibrate from instead of the images in the recording folder." << std::endl;
+        cerr << std::endl << "[-stride]: use every n-th video frame. [-start] [-end]: time range of the video to use, in seconds. [-keyframes]: only use key frames." << std::endl;
+        cerr << std::endl << "[-corr]: file to save the detected correspondences to. When it exists the detections are read from it instead, and a live session continues after the captures it holds." << std::endl;
+        cerr << std::endl << "[-track]: track the board between live frames and only run the full detection when the board is in view. Only use when physical camera is connected." << std::endl;
+        cerr << std::endl << "[-uncertainty]: estimate the standard deviation of the calibration from resamples of the plane points, bootstrap or loo (leave one out). Saved next to the calibration. [-resamples]: number of resamples, defaults to 100." << std::endl;
+        cerr << std::endl << "[-preset]: detection preset, realtime, default or precise. Defaults to default." << std::endl;
+        cerr << std::endl << "[-dbgout]: write the detections with overlays to a folder of images, or to a video when the path ends with .avi, .mp4 or .mkv. Does not need a display." << std::endl;
         cerr << std::endl << "[-d]: whether to use debug mode or not." << std::endl;
         return 0;
     }
 
+    Uncertainty::Method uncertainty;
+    if (!Uncertainty::parse(cml("-uncertainty", "none"), uncertainty))
+        exit(1);
+
+    DetectionPreset::Type preset;
+    if (!DetectionPreset::parse(cml("-preset", "default"), preset))
+        exit(1);
+    DetectorPool::global().setPreset(preset);
+
     std::string recordingFolder = argv[1];
     std::string calibPath = argv[2];
 
     MirrorCalibrator calibrator;
     calibrator.init(recordingFolder, calibPath);
+    calibrator.setPackCaptures(cml["-pack"]);
+    if (!calibrator.setCaptureFormat(cml("-format", "png"), std::stoi(cml("-compression", "1"))))
+        exit(1);
+    calibrator.setGrayscale(cml["-gray"]);
+    if (cml["-dbgout"])
+        calibrator.setDebugOutput(cml("-dbgout"));
+    calibrator.setTracking(cml["-track"]);
+    if (cml["-corr"])
+        calibrator.setCorrespondenceFile(cml("-corr"));
+
+    if (cml["-video"])
+    {
+        VideoSampling sampling;
+        sampling.stride = std::stoi(cml("-stride", "1"));
+        sampling.startTime = std::stod(cml("-start", "0"));
+        sampling.endTime = std::stod(cml("-end", "-1"));
+        sampling.keyframesOnly = cml["-keyframes"];
+        sampling.grayscale = cml["-gray"];
+
+        VideoFrameSource video;
+        if (!video.open(cml("-video"), sampling))
+            exit(1);
 
-    if (cml["-p"] && cml["-camid"])
+        std::cout << "[MirrorCalib]: Running calibration with video " << cml("-video") << std::endl;
+        calibrator.calibrate(video, cml["-d"]);
+    }
+    else if (cml["-p"] && cml["-camid"])
     {
+        DeviceFactory::DeviceProperties properties;
+        if (cml["-gray"])
+            properties["grayscale"] = "1";
+
         DeviceFactory::DeviceFactory df;
         df.listAvailableDevices();
-        std::shared_ptr<DeviceFactory::Device> cam = df.createDevices("RealSense2", cml("-camid"));
+        std::shared_ptr<DeviceFactory::Device> cam = df.createDevices("RealSense2", cml("-camid"), properties);
         if (cam.get() == nullptr)
             exit(1);
         calibrator.calibrate(cam, std::stoi(cml("-p")));
@@ -65,7 +114,9 @@ int main(int argc, char** argv)
         exit(1);
     }
 
-    calibrator.saveToJSON();
+    calibrator.estimateUncertainty(uncertainty, std::stoi(cml("-resamples", "100")));
+    if (!calibrator.saveToJSON())
+        exit(1);
 
     return 0;
 }
\ No newline at end of file
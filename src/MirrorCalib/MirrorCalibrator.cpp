@@ -53,7 +53,7 @@ std::vector<Point3f> MirrorCalibrator::getPlanePointsFull(int debugDelay)
 		exit(1);
 	}
 
-	Mat img = imread(imgsPaths[0]);
+	Mat img = Utils::readImage(imgsPaths[0], grayscale);
 
 	//GaussianBlur(img, img, Size(3, 3), 1);
 
@@ -69,7 +69,7 @@ std::vector<cv::Point3f> MirrorCalibrator::getPlanePointsRV(int debugDelay)
 	int i = 0;
 	for (const auto& entry : Utils::loadImages(imgsFolder))
 	{
-		Mat img = imread(entry);
+		Mat img = Utils::readImage(entry, grayscale);
 		//GaussianBlur(img, img, Size(3, 3), 1);
 
 		detectRV(img, planePoints3d, debugDelay);
@@ -86,6 +86,11 @@ std::vector<cv::Point3f> MirrorCalibrator::getPlanePointsRV(int debugDelay)
 	return planePoints3d;
 }
 
+void MirrorCalibrator::saveCapture(int imgId, const cv::Mat& img)
+{
+	archiver.submit(imgId, img);
+}
+
 std::vector<cv::Point3f> MirrorCalibrator::getPlanePointsFull(std::shared_ptr<DeviceFactory::Device> cam, int debugDelay)
 {
 	int imgId = 0;
@@ -96,17 +101,25 @@ std::vector<cv::Point3f> MirrorCalibrator::getPlanePointsFull(std::shared_ptr<De
 		Mat img; double timestamp;
 		cam->captureImages(img, timestamp);
 
-		Mat saveImg = img.clone();
+		// from2dToCamSpace needs at least 16 corners
+		if (tracker && tracker->track(img) < 16)
+		{
+			imshow("Img", img);
+			if (waitKey(1) == 'q')
+				exit(1);
+			continue;
+		}
 
 		std::cout << "Trying new image..\n";
 
-		bool detected = detectFull(img, planePoints, debugDelay);
+		// The detection draws on its copy, the capture is saved as it is
+		bool detected = detectFull(img.clone(), planePoints, debugDelay);
 		if (detected)
 		{
-			std::stringstream ss;
-			ss << std::setfill('0') << std::setw(2) << imgId << ".png";
-			Utils::verifyDirectories(imgsFolder + "/" + ss.str());
-			imwrite(imgsFolder + "/" + ss.str(), saveImg);
+			if (tracker)
+				tracker->reset();
+
+			saveCapture(imgId, img);
 			++imgId;
 		}
 	}
@@ -114,75 +127,167 @@ std::vector<cv::Point3f> MirrorCalibrator::getPlanePointsFull(std::shared_ptr<De
 	return planePoints;
 }
 
-std::vector<cv::Point3f> MirrorCalibrator::getPlanePointsRV(std::shared_ptr<DeviceFactory::Device> cam, int patterns, int debugDelay)
+std::vector<cv::Point3f> MirrorCalibrator::getPlanePointsRV(std::shared_ptr<DeviceFactory::Device> cam, int patterns, int debugDelay, int firstImgId)
 {
-	int imgId = 0;
+	int imgId = firstImgId;
 	std::vector<Point3f> planePoints3d;
 
+	bool waitForBoard = false;
 	while (imgId < patterns)
 	{
 		Mat img; double timestamp;
 		cam->captureImages(img, timestamp);
 
-		Mat saveImg = img.clone();
+		if (waitForBoard)
+		{
+			waitForBoard = !boardSettle.update(img);
+			if (waitForBoard)
+			{
+				imshow("Img", img);
+				if (waitKey(1) == 'q')
+					exit(1);
+				continue;
+			}
+		}
+
+		if (tracker)
+		{
+			// Both trackers have to see every frame, otherwise their previous frame gets stale
+			size_t realCorners = tracker->track(img);
+			size_t virtualCorners = virtualTracker->track(img, true);
+			if (realCorners < 16 || virtualCorners < 16)
+			{
+				imshow("Img", img);
+				if (waitKey(1) == 'q')
+					exit(1);
+				continue;
+			}
+		}
 
 		std::cout << "Trying new image..\n";
 
-		bool detected = detectRV(img, planePoints3d, debugDelay);
+		bool detected = detectRV(img.clone(), planePoints3d, debugDelay);
 		if (detected)
 		{
-			std::stringstream ss;
-			ss << std::setfill('0') << std::setw(2) << imgId << ".png";
-			Utils::verifyDirectories(imgsFolder + "/" + ss.str());
-			imwrite(imgsFolder + "/" + ss.str(), saveImg);
+			if (tracker)
+			{
+				tracker->reset();
+				virtualTracker->reset();
+			}
+
+			saveCapture(imgId, img);
 			++imgId;
-			waitKey(2000);
+			boardSettle.reset(img);
+			waitForBoard = true;
 		}
 	}
 
 	return planePoints3d;
 }
 
+std::vector<cv::Point3f> MirrorCalibrator::getPlanePointsFull(VideoFrameSource& video, int debugDelay)
+{
+	std::vector<Point3f> planePoints;
+
+	// Full view calibration uses a single observation, take the first frame with a detection
+	Mat img;
+	while (video.next(img))
+	{
+		std::cout << "Loaded frame at " << video.getFrameTime() << "s" << std::endl;
+
+		if (detectFull(img, planePoints, debugDelay))
+			break;
+	}
+
+	if (planePoints.empty())
+	{
+		std::cerr << "[MirrorCalibrator] No full view detection found in video" << std::endl;
+		exit(1);
+	}
+
+	return planePoints;
+}
+
+std::vector<cv::Point3f> MirrorCalibrator::getPlanePointsRV(VideoFrameSource& video, int debugDelay)
+{
+	std::vector<Point3f> planePoints3d;
+
+	Mat img;
+	while (video.next(img))
+	{
+		std::cout << "Loaded frame at " << video.getFrameTime() << "s" << std::endl;
+
+		detectRV(img, planePoints3d, debugDelay);
+	}
+
+	if (planePoints3d.size() < 3)
+	{
+		std::cerr << "[MirrorCalibrator] Not enough points found." << std::endl;
+	}
+
+	return planePoints3d;
+}
+
 bool MirrorCalibrator::detectFull(cv::Mat img, std::vector<cv::Point3f>& planePoints, int debugDelay)
 {
 	Mat gray;
-	cvtColor(img, gray, COLOR_BGR2GRAY);
+	Utils::toGray(img, gray);
 
 	std::vector<Point2f> corners;
 	std::vector<int> ids;
-	detector.detectCharucoCorners(gray, corners, ids);
+	detector->detectCharucoCorners(gray, corners, ids);
+
+	debugSink.submit("full", img, { DebugOverlay::charuco(corners, ids) });
 
 	if (debugDelay >= 0)
 	{
-		cv::aruco::drawDetectedCornersCharuco(img, corners, ids, cv::Scalar(0, 255, 0));
-		imshow("Img", img);
+		// img can be a read only frame of a packed recording
+		Mat shown;
+		if (img.channels() == 1)
+			cvtColor(img, shown, COLOR_GRAY2BGR);
+		else
+			shown = img.clone();
+		cv::aruco::drawDetectedCornersCharuco(shown, corners, ids, cv::Scalar(0, 255, 0));
+		imshow("Img", shown);
 		if (waitKey(debugDelay) == 'q')
 			exit(1);
 	}
 
 	planePoints = from2dToCamSpace(corners, ids);
 
+	if (!planePoints.empty() && correspondenceWriter.isOpened())
+		correspondenceWriter.write(correspondenceWriter.getViews(), img.size(), { Mat(planePoints) });
+
 	return not planePoints.empty();
 }
 
 bool MirrorCalibrator::detectRV(cv::Mat img, std::vector<cv::Point3f>& planePoints, int debugDelay)
 {
 	Mat gray;
-	cvtColor(img, gray, COLOR_BGR2GRAY);
+	Utils::toGray(img, gray);
 
 	std::vector<Point2f> realPoints2d, virtualPoints2d;
 	std::vector<int> realIds, virtualIds;
 
-	detector.detectCharucoCorners(gray, realPoints2d, realIds);
-	flip(gray, gray, 1);
-	detector.detectCharucoCorners(gray, virtualPoints2d, virtualIds);
+	detector->detectCharucoCorners(gray, realPoints2d, realIds);
+	Mat grayFlipped;
+	flip(gray, grayFlipped, 1);
+	detector->detectCharucoCorners(grayFlipped, virtualPoints2d, virtualIds);
 	Utils::flip2dPoints(virtualPoints2d, gray.size().width);
 
+	debugSink.submit("rv", img, { DebugOverlay::charuco(realPoints2d, realIds), DebugOverlay::charuco(virtualPoints2d, virtualIds, cv::Scalar(255, 0, 0)) });
+
 	if (debugDelay >= 0)
 	{
-		cv::aruco::drawDetectedCornersCharuco(img, realPoints2d, realIds, cv::Scalar(0, 255, 0));
-		cv::aruco::drawDetectedCornersCharuco(img, virtualPoints2d, virtualIds, cv::Scalar(0, 255, 0));
-		imshow("Img", img);
+		// img can be a read only frame of a packed recording
+		Mat shown;
+		if (img.channels() == 1)
+			cvtColor(img, shown, COLOR_GRAY2BGR);
+		else
+			shown = img.clone();
+		cv::aruco::drawDetectedCornersCharuco(shown, realPoints2d, realIds, cv::Scalar(0, 255, 0));
+		cv::aruco::drawDetectedCornersCharuco(shown, virtualPoints2d, virtualIds, cv::Scalar(0, 255, 0));
+		imshow("Img", shown);
 		if (waitKey(debugDelay) == 'q')
 			exit(1);
 	}
@@ -195,6 +300,9 @@ bool MirrorCalibrator::detectRV(cv::Mat img, std::vector<cv::Point3f>& planePoin
 	if (midPoints3d.size() > 8)
 	{
 		planePoints.insert(planePoints.end(), midPoints3d.begin(), midPoints3d.end());
+
+		if (correspondenceWriter.isOpened())
+			correspondenceWriter.write(correspondenceWriter.getViews(), img.size(), { Mat(midPoints3d) });
 		return true;
 	}
 	else
@@ -237,8 +345,71 @@ std::vector<cv::Point3f> MirrorCalibrator::computeMidPoints(const std::vector<cv
 }
 
 
-MirrorCalibrator::MirrorCalibrator()
+MirrorCalibrator::MirrorCalibrator(): detector{DetectorPool::global().acquireCharucoDetector()}, streamedDetections{0}, packCaptures{false}, grayscale{false}, boardSettle{5}
+{
+}
+
+void MirrorCalibrator::setDetector(std::shared_ptr<CharucoDetector> detector)
+{
+	this->detector = detector;
+}
+
+void MirrorCalibrator::setPackCaptures(bool packCaptures)
+{
+	this->packCaptures = packCaptures;
+}
+
+bool MirrorCalibrator::setCaptureFormat(const std::string& format, int compression)
+{
+	return archiver.setFormat(format, compression);
+}
+
+void MirrorCalibrator::setGrayscale(bool grayscale)
+{
+	this->grayscale = grayscale;
+}
+
+void MirrorCalibrator::setDebugOutput(const std::string& output)
+{
+	debugSink.open(output);
+}
+
+void MirrorCalibrator::setTracking(bool tracking)
+{
+	if (tracking)
+	{
+		tracker = std::make_unique<CharucoTracker>(detector);
+		virtualTracker = std::make_unique<CharucoTracker>(detector);
+	}
+	else
+	{
+		tracker.reset();
+		virtualTracker.reset();
+	}
+}
+
+void MirrorCalibrator::setCorrespondenceFile(const std::string& fileName)
+{
+	correspondenceFile = fileName;
+}
+
+int MirrorCalibrator::loadCorrespondences(std::vector<Point3f>& planePoints)
 {
+	CorrespondenceStore store;
+	if (correspondenceFile.empty() || !store.open(correspondenceFile, { 3 }))
+		return 0;
+
+	// Full view calibration only uses the last detection, reflection calibration all of them
+	bool full = std::filesystem::path(imgsFolder).filename().string()[0] == 'F';
+	for (int i = full ? store.size() - 1 : 0; i < store.size(); ++i)
+	{
+		std::vector<Point3f> points;
+		store.getPoints(i, 0).copyTo(points);
+		planePoints.insert(planePoints.end(), points.begin(), points.end());
+	}
+
+	std::cout << "[MirrorCalibrator] Loaded " << store.size() << " views from " << correspondenceFile << std::endl;
+	return store.size();
 }
 
 void MirrorCalibrator::init(const std::string& recording, const std::string& camCalibName)
@@ -246,9 +417,9 @@ void MirrorCalibrator::init(const std::string& recording, const std::string& cam
 	imgsFolder = recording;
 	this->camCalibName = camCalibName;
 
-	for (int i = 0; i < detector.getBoardSize().height; i++)
+	for (int i = 0; i < detector->getBoardSize().height; i++)
 	{
-		for (int j = 0; j < detector.getBoardSize().width; j++)
+		for (int j = 0; j < detector->getBoardSize().width; j++)
 		{
 			objp.push_back(Point3f{ (float)j * 2.22f, (float)i * 2.22f, 0.0f }); // real 1.65f fake 2.22f
 		}
@@ -263,9 +434,19 @@ void MirrorCalibrator::init(const std::string& recording, const std::string& cam
 
 void MirrorCalibrator::calibrate(bool debug)
 {
+	// The detections of an earlier run are solved again without reading the images
+	std::vector<Point3f> planePoints;
+	if (loadCorrespondences(planePoints) > 0)
+	{
+		if (!solvePlane(planePoints))
+			exit(1);
+		return;
+	}
+
+	if (!correspondenceFile.empty())
+		correspondenceWriter.open(correspondenceFile, { 3 });
 
 	std::string lastFolder = std::filesystem::path(imgsFolder).filename().string();
-	std::vector<Point3f> planePoints;
 	if (lastFolder[0] == 'F')
 	{
 		std::cout << "[MirrorCalibrator]: Running full view mirror calibration" << std::endl;
@@ -283,29 +464,159 @@ void MirrorCalibrator::calibrate(bool debug)
 			planePoints = getPlanePointsRV();
 	}
 
-	destroyAllWindows();
-	mp.fromPoints(planePoints);
+	if (debug)
+		destroyAllWindows();
+	correspondenceWriter.close();
+	if (!solvePlane(planePoints))
+		exit(1);
 }
 
 void MirrorCalibrator::calibrate(std::shared_ptr<DeviceFactory::Device> cam, int patterns)
 {
+	// An interrupted session continues after the captures it already has
 	std::vector<Point3f> planePoints;
+	int captured = loadCorrespondences(planePoints);
+	if (!correspondenceFile.empty())
+		correspondenceWriter.open(correspondenceFile, { 3 }, true);
+
+	if (!archiver.open(imgsFolder, packCaptures, captured > 0))
+	{
+		std::cerr << "[MirrorCalibrator] Error: Could not open " << imgsFolder << " for the captures" << std::endl;
+		exit(1);
+	}
+
 	if (imgsFolder[0] == 'F')
 	{
-		planePoints = getPlanePointsFull(cam, 150);
+		if (captured == 0)
+			planePoints = getPlanePointsFull(cam, 150);
 	}
 	else if (imgsFolder[0] == 'M')
 	{
-		planePoints = getPlanePointsRV(cam, patterns, 150);
+		std::vector<Point3f> newPoints = getPlanePointsRV(cam, patterns, 150, captured);
+		planePoints.insert(planePoints.end(), newPoints.begin(), newPoints.end());
 	}
+	archiver.close();
+	correspondenceWriter.close();
 	destroyAllWindows();
 
-	mp.fromPoints(planePoints);
+	if (!solvePlane(planePoints))
+		exit(1);
+}
+
+void MirrorCalibrator::calibrate(VideoFrameSource& video, bool debug)
+{
+	int debugDelay = -1;
+	if (debug)
+		debugDelay = 0;
+
+	std::vector<Point3f> planePoints;
+	if (loadCorrespondences(planePoints) > 0)
+	{
+		if (!solvePlane(planePoints))
+			exit(1);
+		return;
+	}
+
+	if (!correspondenceFile.empty())
+		correspondenceWriter.open(correspondenceFile, { 3 });
+
+	std::string lastFolder = std::filesystem::path(imgsFolder).filename().string();
+	if (lastFolder[0] == 'F')
+	{
+		std::cout << "[MirrorCalibrator]: Running full view mirror calibration" << std::endl;
+		planePoints = getPlanePointsFull(video, debugDelay);
+	}
+	else if (lastFolder[0] == 'M')
+	{
+		std::cout << "[MirrorCalibrator]: Running reflection mirror calibration" << std::endl;
+		planePoints = getPlanePointsRV(video, debugDelay);
+	}
+
+	destroyAllWindows();
+	correspondenceWriter.close();
+	if (!solvePlane(planePoints))
+		exit(1);
 }
 
-void MirrorCalibrator::saveToJSON()
+bool MirrorCalibrator::addFrame(const Mat& img)
 {
 	std::string lastFolder = std::filesystem::path(imgsFolder).filename().string();
+	bool detected = false;
+
+	// Full view calibration uses a single observation, the last detection replaces the previous ones
+	if (lastFolder[0] == 'F')
+	{
+		std::vector<Point3f> planePoints;
+		detected = detectFull(img, planePoints);
+		if (detected)
+			streamedPlanePoints = planePoints;
+	}
+	else if (lastFolder[0] == 'M')
+	{
+		detected = detectRV(img, streamedPlanePoints);
+	}
+
+	if (detected)
+		++streamedDetections;
+
+	return detected;
+}
+
+bool MirrorCalibrator::solve()
+{
+	if (streamedPlanePoints.size() < 3)
+	{
+		std::cerr << "[MirrorCalibrator] Not enough points found." << std::endl;
+		return false;
+	}
+
+	return solvePlane(streamedPlanePoints);
+}
+
+int MirrorCalibrator::getDetections() const
+{
+	return streamedDetections;
+}
+
+bool MirrorCalibrator::solvePlane(const std::vector<Point3f>& planePoints)
+{
+	solvedPoints = planePoints;
+	return mp.fromPoints(planePoints);
+}
+
+void MirrorCalibrator::estimateUncertainty(Uncertainty::Method method, int resamples)
+{
+	// A single full view can not be resampled, the plane points are resampled instead of the views
+	Vec4f fullPlane = mp.getPlaneParams();
+	std::vector<double> stds = Uncertainty::estimate(method, solvedPoints.size(), resamples, [&](const std::vector<int>& points)
+	{
+		std::vector<Point3f> samplePoints;
+		for (int p : points)
+			samplePoints.push_back(solvedPoints[p]);
+
+		// The sign of a plane is arbitrary, it follows the plane of all points
+		MirrorPlane samplePlane;
+		if (!samplePlane.fromPoints(samplePoints))
+			return std::vector<double>{};
+		Vec4f plane = samplePlane.getPlaneParams();
+		if (plane[0] * fullPlane[0] + plane[1] * fullPlane[1] + plane[2] * fullPlane[2] < 0)
+			plane = -plane;
+
+		return std::vector<double>{ plane[0], plane[1], plane[2], plane[3] };
+	});
+
+	if (stds.empty())
+	{
+		std::cerr << "[MirrorCalibrator] Not enough points to estimate the uncertainty" << std::endl;
+		return;
+	}
+
+	planeStd = stds;
+	std::cout << "Plane std: " << Mat(planeStd).t() << std::endl;
+}
+
+bool MirrorCalibrator::saveToJSON()
+{
 	std::string seqName = std::filesystem::path(camCalibName).filename().string();
-	mp.saveToJSON(Config::mirrorCalibrationFolder + seqName);
+	return mp.saveToJSON(Config::mirrorCalibrationFolder + seqName, planeStd);
 }
@@ -1,10 +1,18 @@
 #pragma once
 #include "MirrorPlane.h"
 #include "CharucoDetector.h"
+#include "DetectorPool.h"
 #include "DeviceFactory/CameraCalibration.h"
 #include <vector>
 #include "Config.h"
 #include "DeviceFactory/Device.h"
+#include "VideoFrameSource.h"
+#include "FrameArchiver.h"
+#include "DebugSink.h"
+#include "CharucoTracker.h"
+#include "CorrespondenceStore.h"
+#include "Uncertainty.h"
+#include "SettleDetector.h"
 
 class MirrorCalibrator
 {
@@ -13,10 +21,38 @@ private:
 	std::string camCalibName;
 
 	MirrorPlane mp;
-	CharucoDetector detector;
+
+	// Points the plane was solved from, and the standard deviation of its parameters when estimated
+	std::vector<cv::Point3f> solvedPoints;
+	std::vector<double> planeStd;
+	std::shared_ptr<CharucoDetector> detector;
 	CameraCalibration camCalib;
 
 	std::vector<cv::Point3f> objp;
+	std::vector<cv::Point3f> streamedPlanePoints;
+	int streamedDetections;
+
+	bool packCaptures;
+	FrameArchiver archiver;
+
+	bool grayscale;
+
+	DebugSink debugSink;
+
+	// Only set in tracking mode, the virtual board is tracked in the flipped frame
+	std::unique_ptr<CharucoTracker> tracker;
+	std::unique_ptr<CharucoTracker> virtualTracker;
+
+	// Plane points of every detection, in camera space
+	std::string correspondenceFile;
+	CorrespondenceWriter correspondenceWriter;
+
+	// After a live capture, the next one waits until the board was moved and held still
+	SettleDetector boardSettle;
+
+	void saveCapture(int imgId, const cv::Mat& img);
+	int loadCorrespondences(std::vector<cv::Point3f>& planePoints);
+	bool solvePlane(const std::vector<cv::Point3f>& planePoints);
 
 	std::vector<cv::Point3f> from2dToCamSpace(std::vector<cv::Point2f> points2d, std::vector<int>& ids);
 
@@ -24,7 +60,10 @@ private:
 	std::vector<cv::Point3f> getPlanePointsRV(int debugDelay = -1);
 
 	std::vector<cv::Point3f> getPlanePointsFull(std::shared_ptr<DeviceFactory::Device> cam, int debugDelay = -1);
-	std::vector<cv::Point3f> getPlanePointsRV(std::shared_ptr<DeviceFactory::Device> cam, int patterns, int debugDelay = -1);
+	std::vector<cv::Point3f> getPlanePointsRV(std::shared_ptr<DeviceFactory::Device> cam, int patterns, int debugDelay = -1, int firstImgId = 0);
+
+	std::vector<cv::Point3f> getPlanePointsFull(VideoFrameSource& video, int debugDelay = -1);
+	std::vector<cv::Point3f> getPlanePointsRV(VideoFrameSource& video, int debugDelay = -1);
 
 	bool detectFull(cv::Mat img, std::vector<cv::Point3f>& planePoints, int debugDelay = -1);
 	bool detectRV(cv::Mat img, std::vector<cv::Point3f>& planePoints, int debugDelay = -1);
@@ -35,10 +74,31 @@ private:
 public:
 	MirrorCalibrator();
 
+	// objp is built from the board of the detector in init
+	void setDetector(std::shared_ptr<CharucoDetector> detector);
 	void init(const std::string& recording, const std::string& camCalibPath = "camGT");
+	void setPackCaptures(bool packCaptures);
+	// Image format and PNG compression level of the live captures, see FrameArchiver::setFormat
+	bool setCaptureFormat(const std::string& format, int compression);
+	void setGrayscale(bool grayscale);
+	void setDebugOutput(const std::string& output);
+	void setTracking(bool tracking);
+
+	// Detections are saved to the file, and read from it instead of detected again when it exists
+	void setCorrespondenceFile(const std::string& fileName);
 
 	void calibrate(bool debug = false);
 	void calibrate(std::shared_ptr<DeviceFactory::Device> cam, int patterns);
-	void saveToJSON();
+	void calibrate(VideoFrameSource& video, bool debug = false);
+
+	// Frame by frame calibration for frames that are not read from a recording
+	bool addFrame(const cv::Mat& img);
+	bool solve();
+	int getDetections() const;
+
+	// Standard deviations of the plane parameters from resamples of the plane points, call after calibrate
+	void estimateUncertainty(Uncertainty::Method method, int resamples = 100);
+
+	bool saveToJSON();
 };
 
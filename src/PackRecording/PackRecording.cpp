@@ -0,0 +1,69 @@
+#include <iostream>
+#include <vector>
+#include <filesystem>
+#include <opencv2/imgcodecs.hpp>
+#include "PackedRecording.h"
+#include "Config.h"
+#include "Utils.h"
+
+using namespace std;
+
+class CmdLineParser {
+
+private:
+    int argc; char** argv;
+
+public:
+    CmdLineParser(int _argc, char** _argv) :argc(_argc), argv(_argv) {}  bool operator[] (string param) { int idx = -1;  for (int i = 0; i < argc && idx == -1; i++) if (string(argv[i]) == param) idx = i;	return (idx != -1); } string operator()(string param, string defvalue = "") { int idx = -1;	for (int i = 0; i < argc && idx == -1; i++) if (string(argv[i]) == param) idx = i; if (idx == -1) return defvalue;   else  return (argv[idx + 1]); }
+};
+
+int main(int argc, char** argv)
+{
+    CmdLineParser cml(argc, argv);
+    if (argc < 2 || cml["-h"]) {
+        cerr << std::endl << "Usage: ./PackRecording recording [-o output] [-png] [-color]" << std::endl;
+        cerr << std::endl << "recording: folder containing the numbered images of a recording (or patterns)." << std::endl;
+        cerr << std::endl << "[-o]: packed recording to write, defaults to recording/" << Config::packedRecordingFile << ", where the calibration tools look for it." << std::endl;
+        cerr << std::endl << "[-png]: store frames with fast PNG compression instead of raw." << std::endl;
+        cerr << std::endl << "[-color]: keep the colour channels instead of storing grayscale frames." << std::endl;
+        return 0;
+    }
+
+    std::string recordingFolder = argv[1];
+    std::string output = cml("-o", recordingFolder + "/" + Config::packedRecordingFile);
+
+    if (std::filesystem::exists(output))
+    {
+        cerr << "[PackRecording]: " << output << " already exists" << endl;
+        exit(1);
+    }
+
+    // Collect the images before the output is created, loadImages prefers an existing pack
+    std::vector<std::string> images = Utils::loadImages(recordingFolder);
+    if (images.empty())
+    {
+        cerr << "[PackRecording]: No images found in " << recordingFolder << endl;
+        exit(1);
+    }
+
+    PackedRecordingWriter writer;
+    if (!writer.open(output, cml["-png"] ? PackedRecording::PNG : PackedRecording::RAW, !cml["-color"]))
+        exit(1);
+
+    for (const auto& entry : images)
+    {
+        cv::Mat img = cv::imread(entry, cml["-color"] ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE);
+        if (img.empty())
+        {
+            cerr << "[PackRecording]: Could not read " << entry << endl;
+            exit(1);
+        }
+
+        int id = std::stoi(std::filesystem::path(entry).stem().string());
+        writer.write(id, img);
+    }
+
+    writer.close();
+
+    return 0;
+}
@@ -0,0 +1,210 @@
+#include "GrayCodePattern.h"
+#include <iostream>
+#include <opencv2/core.hpp>
+
+using namespace cv;
+
+static int bitsFor(int values)
+{
+	int bits = 0;
+	while ((1 << bits) < values)
+		++bits;
+	return bits;
+}
+
+GrayCodePattern::GrayCodePattern(const Size& resolution, int lineShift): resolution{resolution}, lineShift{lineShift}
+{
+	if (lineShift < 1 || (lineShift & (lineShift - 1)) != 0)
+	{
+		std::cerr << "[GrayCodePattern] Line shift should be a power of two, got " << lineShift << std::endl;
+		exit(1);
+	}
+
+	colBits = bitsFor((resolution.width + lineShift - 1) / lineShift);
+	rowBits = bitsFor((resolution.height + lineShift - 1) / lineShift);
+}
+
+std::vector<Mat> GrayCodePattern::generateAxis(int length, int bits, bool columns) const
+{
+	std::vector<Mat> patterns;
+
+	Mat line(1, length, CV_8U);
+	for (int i = 0; i < bits; ++i)
+	{
+		for (int x = 0; x < length; ++x)
+		{
+			int stripe = x / lineShift;
+			int gray = stripe ^ (stripe >> 1);
+			line.at<uchar>(x) = ((gray >> (bits - 1 - i)) & 1) ? 255 : 0;
+		}
+
+		Mat pattern = columns ? repeat(line, resolution.height, 1) : repeat(line.t(), 1, resolution.width);
+		patterns.push_back(pattern);
+		patterns.push_back(255 - pattern);
+	}
+
+	if (lineShift > 1)
+	{
+		for (int j = 0; j < lineShift; ++j)
+		{
+			for (int x = 0; x < length; ++x)
+			{
+				line.at<uchar>(x) = (x % lineShift == j) ? 255 : 0;
+			}
+			patterns.push_back(columns ? repeat(line, resolution.height, 1) : repeat(line.t(), 1, resolution.width));
+		}
+	}
+
+	return patterns;
+}
+
+std::vector<Mat> GrayCodePattern::generate() const
+{
+	std::vector<Mat> patterns;
+	patterns.push_back(Mat(resolution, CV_8U, Scalar(255)));
+	patterns.push_back(Mat(resolution, CV_8U, Scalar(0)));
+
+	std::vector<Mat> cols = generateAxis(resolution.width, colBits, true);
+	std::vector<Mat> rows = generateAxis(resolution.height, rowBits, false);
+
+	// Bits of both axes first, then the line shifts of both axes
+	int colShiftFirst = 2 * colBits;
+	int rowShiftFirst = 2 * rowBits;
+	patterns.insert(patterns.end(), cols.begin(), cols.begin() + colShiftFirst);
+	patterns.insert(patterns.end(), rows.begin(), rows.begin() + rowShiftFirst);
+	patterns.insert(patterns.end(), cols.begin() + colShiftFirst, cols.end());
+	patterns.insert(patterns.end(), rows.begin() + rowShiftFirst, rows.end());
+
+	return patterns;
+}
+
+int GrayCodePattern::getNrPatterns() const
+{
+	int shifts = lineShift > 1 ? lineShift : 0;
+	return 2 + 2 * colBits + 2 * rowBits + 2 * shifts;
+}
+
+Size GrayCodePattern::getResolution() const
+{
+	return resolution;
+}
+
+void GrayCodePattern::decodeBits(const std::vector<Mat>& frames, int first, int bits, Mat& stripe, Mat& valid, int contrastThreshold) const
+{
+	stripe = Mat::zeros(valid.size(), CV_32S);
+
+	// Binary bit of the previous, more significant, bit. Every binary bit is the xor of the Gray bits up to it.
+	Mat binary = Mat::zeros(valid.size(), CV_8U);
+	Mat bit, contrast;
+	for (int i = 0; i < bits; ++i)
+	{
+		const Mat& pos = frames[first + 2 * i];
+		const Mat& neg = frames[first + 2 * i + 1];
+
+		compare(pos, neg, bit, CMP_GT);
+		bitwise_xor(binary, bit, binary);
+		add(stripe, Scalar(1 << (bits - 1 - i)), stripe, binary);
+
+		absdiff(pos, neg, contrast);
+		compare(contrast, contrastThreshold, contrast, CMP_GE);
+		bitwise_and(valid, contrast, valid);
+	}
+}
+
+void GrayCodePattern::decodeShift(const std::vector<Mat>& frames, int first, const Mat& black, const Mat& stripe, Mat& coord, Mat& valid, int contrastThreshold) const
+{
+	Mat maxValue = frames[first].clone();
+	Mat maxShift = Mat::zeros(valid.size(), CV_8U);
+	Mat brighter;
+	for (int j = 1; j < lineShift; ++j)
+	{
+		compare(frames[first + j], maxValue, brighter, CMP_GT);
+		frames[first + j].copyTo(maxValue, brighter);
+		maxShift.setTo(j, brighter);
+	}
+
+	Mat contrast;
+	subtract(maxValue, black, contrast);
+	compare(contrast, contrastThreshold, contrast, CMP_GE);
+	bitwise_and(valid, contrast, valid);
+
+	coord.create(valid.size(), CV_32F);
+	parallel_for_(Range(0, valid.rows), [&](const Range& range)
+	{
+		for (int y = range.start; y < range.end; ++y)
+		{
+			const int* s = stripe.ptr<int>(y);
+			const uchar* m = maxShift.ptr<uchar>(y);
+			float* c = coord.ptr<float>(y);
+			for (int x = 0; x < valid.cols; ++x)
+			{
+				int j = m[x];
+
+				// Peak of the parabola through the brightest shift and its neighbours
+				float offset = 0;
+				if (j > 0 && j < lineShift - 1)
+				{
+					float l = frames[first + j - 1].ptr<uchar>(y)[x];
+					float p = frames[first + j].ptr<uchar>(y)[x];
+					float r = frames[first + j + 1].ptr<uchar>(y)[x];
+					float curvature = l - 2 * p + r;
+					if (curvature < 0)
+						offset = 0.5f * (l - r) / curvature;
+				}
+
+				c[x] = s[x] * lineShift + j + offset;
+			}
+		}
+	});
+}
+
+bool GrayCodePattern::decode(const std::vector<Mat>& frames, Mat& projCoords, Mat& valid, int contrastThreshold) const
+{
+	if ((int)frames.size() != getNrPatterns())
+	{
+		std::cerr << "[GrayCodePattern] Expected " << getNrPatterns() << " frames, got " << frames.size() << std::endl;
+		return false;
+	}
+
+	for (const auto& frame : frames)
+	{
+		if (frame.type() != CV_8UC1 || frame.size() != frames[whiteFrame].size())
+		{
+			std::cerr << "[GrayCodePattern] Frames should be grayscale and of the same size" << std::endl;
+			return false;
+		}
+	}
+
+	// Pixels in the shadow of the projector
+	const Mat& black = frames[whiteFrame + 1];
+	Mat lit;
+	subtract(frames[whiteFrame], black, lit);
+	compare(lit, contrastThreshold, valid, CMP_GE);
+
+	Mat colStripe, rowStripe;
+	decodeBits(frames, 2, colBits, colStripe, valid, contrastThreshold);
+	decodeBits(frames, 2 + 2 * colBits, rowBits, rowStripe, valid, contrastThreshold);
+
+	Mat colCoord, rowCoord;
+	if (lineShift > 1)
+	{
+		int shiftFirst = 2 + 2 * colBits + 2 * rowBits;
+		decodeShift(frames, shiftFirst, black, colStripe, colCoord, valid, contrastThreshold);
+		decodeShift(frames, shiftFirst + lineShift, black, rowStripe, rowCoord, valid, contrastThreshold);
+	}
+	else
+	{
+		colStripe.convertTo(colCoord, CV_32F);
+		rowStripe.convertTo(rowCoord, CV_32F);
+	}
+
+	// Stripes past the border of the projector can only come from decoding errors
+	Mat inside;
+	compare(colCoord, resolution.width, inside, CMP_LT);
+	bitwise_and(valid, inside, valid);
+	compare(rowCoord, resolution.height, inside, CMP_LT);
+	bitwise_and(valid, inside, valid);
+
+	merge(std::vector<Mat>{ colCoord, rowCoord }, projCoords);
+	return true;
+}
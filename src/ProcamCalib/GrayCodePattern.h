@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include <opencv2/core.hpp>
+#include "StructuredLightPattern.h"
+
+// Gray code and line shift structured light. The sequence is a white and a black frame, every bit of the column and row
+// Gray codes followed by its inverse, and lineShift frames with a line every lineShift columns (rows) shifted by one
+// pixel each time. The Gray codes only identify the stripe of lineShift pixels a camera pixel sees, the line shift frames
+// give the column (row) within the stripe with subpixel precision. A lineShift of 1 decodes the Gray codes to full resolution.
+class GrayCodePattern : public StructuredLightPattern
+{
+private:
+	cv::Size resolution;
+	int lineShift;
+	int colBits;
+	int rowBits;
+
+	std::vector<cv::Mat> generateAxis(int length, int bits, bool columns) const;
+	void decodeBits(const std::vector<cv::Mat>& frames, int first, int bits, cv::Mat& stripe, cv::Mat& valid, int contrastThreshold) const;
+	void decodeShift(const std::vector<cv::Mat>& frames, int first, const cv::Mat& black, const cv::Mat& stripe, cv::Mat& coord, cv::Mat& valid, int contrastThreshold) const;
+
+public:
+	GrayCodePattern(const cv::Size& resolution, int lineShift = 8);
+
+	std::vector<cv::Mat> generate() const override;
+	int getNrPatterns() const override;
+	cv::Size getResolution() const override;
+	bool decode(const std::vector<cv::Mat>& frames, cv::Mat& projCoords, cv::Mat& valid, int contrastThreshold = 10) const override;
+};
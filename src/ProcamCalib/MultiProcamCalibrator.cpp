@@ -0,0 +1,123 @@
+#include "MultiProcamCalibrator.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <thread>
+
+MultiProcamCalibrator::MultiProcamCalibrator(): grayscale{false}, maxThreads{0}
+{
+}
+
+void MultiProcamCalibrator::init(const std::string& imgsFolder, const std::string& mirrorCalibName, const std::string& camCalibName)
+{
+	this->imgsFolder = imgsFolder;
+	this->mirrorCalibName = mirrorCalibName;
+	this->camCalibName = camCalibName;
+}
+
+void MultiProcamCalibrator::addProjector(const std::string& name, const std::string& patternFolder)
+{
+	for (const auto& setup : projectors)
+	{
+		if (setup.name == name)
+		{
+			std::cerr << "[MultiProcamCalibrator] Projector " << name << " is specified twice" << std::endl;
+			exit(1);
+		}
+	}
+
+	std::string projFolder = (std::filesystem::path(imgsFolder) / name).string();
+	if (!std::filesystem::exists(projFolder))
+	{
+		std::cerr << "[MultiProcamCalibrator] Recording folder " << projFolder << " of projector " << name << " does not exist" << std::endl;
+		exit(1);
+	}
+
+	ProjectorSetup setup;
+	setup.name = name;
+	setup.proj = std::make_unique<Projector>(patternFolder);
+	setup.calibrator = std::make_unique<ProcamCalibrator>();
+
+	if (mirrorCalibName.empty())
+	{
+		if (!setup.calibrator->init(projFolder, setup.proj.get(), camCalibName))
+			exit(1);
+	}
+	else if (!setup.calibrator->init(projFolder, mirrorCalibName, setup.proj.get(), camCalibName))
+		exit(1);
+
+	std::string seqName = std::filesystem::path(imgsFolder).filename().string();
+	setup.calibrator->setOutputName(seqName + "_" + name);
+
+	projectors.push_back(std::move(setup));
+}
+
+void MultiProcamCalibrator::setGrayscale(bool grayscale)
+{
+	this->grayscale = grayscale;
+}
+
+void MultiProcamCalibrator::setDebugOutput(const std::string& output)
+{
+	debugOutput = output;
+}
+
+void MultiProcamCalibrator::setMaxThreads(int maxThreads)
+{
+	this->maxThreads = maxThreads;
+}
+
+int MultiProcamCalibrator::getNrProjectors() const
+{
+	return (int)projectors.size();
+}
+
+void MultiProcamCalibrator::calibrate()
+{
+	for (auto& setup : projectors)
+	{
+		setup.calibrator->setGrayscale(grayscale);
+		if (!debugOutput.empty())
+			setup.calibrator->setDebugOutput((std::filesystem::path(debugOutput) / setup.name).string());
+	}
+
+	int nrThreads = maxThreads > 0 ? maxThreads : (int)std::thread::hardware_concurrency();
+	nrThreads = std::max(1, std::min(nrThreads, (int)projectors.size()));
+
+	std::cout << "[MultiProcamCalibrator] Calibrating " << projectors.size() << " projectors on " << nrThreads << " threads" << std::endl;
+	auto start = std::chrono::steady_clock::now();
+
+	// Every projector has its own calibrator, detectors and pattern set, only the camera and mirror calibration are shared.
+	// Debug windows are not used here, highgui can only be driven from the main thread.
+	std::atomic<int> next{ 0 };
+	std::vector<std::thread> workers;
+	for (int t = 0; t < nrThreads; ++t)
+	{
+		workers.emplace_back([this, &next]()
+		{
+			int i;
+			while ((i = next++) < (int)projectors.size())
+			{
+				projectors[i].calibrator->calibrate(false);
+			}
+		});
+	}
+
+	for (auto& worker : workers)
+		worker.join();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "[MultiProcamCalibrator] Calibrated " << projectors.size() << " projectors in " << seconds << "s" << std::endl;
+}
+
+bool MultiProcamCalibrator::saveToJSON()
+{
+	bool saved = true;
+	for (auto& setup : projectors)
+	{
+		saved &= setup.calibrator->saveToJSON();
+	}
+	return saved;
+}
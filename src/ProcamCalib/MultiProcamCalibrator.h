@@ -0,0 +1,45 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "Projector.h"
+#include "ProcamCalibrator.h"
+
+// Calibrates several projectors against the same camera and mirror plane. Every projector has its own pattern set
+// and its own subfolder in the recording, the projectors are detected and solved concurrently.
+class MultiProcamCalibrator
+{
+private:
+	struct ProjectorSetup
+	{
+		std::string name;
+		std::unique_ptr<Projector> proj;
+		std::unique_ptr<ProcamCalibrator> calibrator;
+	};
+
+	std::string imgsFolder;
+	std::string mirrorCalibName;
+	std::string camCalibName;
+
+	std::vector<ProjectorSetup> projectors;
+
+	bool grayscale;
+	std::string debugOutput;
+	int maxThreads;
+
+public:
+	MultiProcamCalibrator();
+
+	void init(const std::string& imgsFolder, const std::string& mirrorCalibName, const std::string& camCalibName = "camGT");
+	void addProjector(const std::string& name, const std::string& patternFolder);
+
+	void setGrayscale(bool grayscale);
+	void setDebugOutput(const std::string& output);
+	void setMaxThreads(int maxThreads);
+
+	int getNrProjectors() const;
+
+	void calibrate();
+	bool saveToJSON();
+};
+
@@ -0,0 +1,77 @@
+#include "PatternGenerator.h"
+#include <iostream>
+#include <opencv2/imgproc.hpp>
+
+using namespace cv;
+
+PatternGenerator::PatternGenerator(const CirclesGridLayout& layout): layout{layout}
+{
+	Size2f extent = Size2f((2 * layout.gridSize.width - 1) * layout.spacing + 2 * layout.radius, (layout.gridSize.height - 1) * layout.spacing + 2 * layout.radius);
+	if (extent.width + 2 * layout.margin > layout.resolution.width || extent.height + 2 * layout.margin > layout.resolution.height)
+	{
+		std::cerr << "[PatternGenerator] A circle grid of " << extent.width << "x" << extent.height << " pixels does not fit in " << layout.resolution.width << "x" << layout.resolution.height << std::endl;
+		exit(1);
+	}
+
+	if (layout.placements.width < 1 || layout.placements.height < 1)
+	{
+		std::cerr << "[PatternGenerator] Needs at least one placement along both axes" << std::endl;
+		exit(1);
+	}
+}
+
+Point2f PatternGenerator::gridOrigin(int patternId) const
+{
+	float width = (2 * layout.gridSize.width - 1) * layout.spacing + 2 * layout.radius;
+	float height = (layout.gridSize.height - 1) * layout.spacing + 2 * layout.radius;
+	float freeX = layout.resolution.width - 2 * layout.margin - width;
+	float freeY = layout.resolution.height - 2 * layout.margin - height;
+
+	// Placements go row by row, a single placement along an axis is centred
+	int px = patternId % layout.placements.width;
+	int py = patternId / layout.placements.width;
+	float fx = layout.placements.width > 1 ? (float)px / (layout.placements.width - 1) : 0.5f;
+	float fy = layout.placements.height > 1 ? (float)py / (layout.placements.height - 1) : 0.5f;
+
+	return Point2f(layout.margin + fx * freeX + layout.radius, layout.margin + fy * freeY + layout.radius);
+}
+
+int PatternGenerator::getNrPatterns() const
+{
+	return layout.placements.area();
+}
+
+const CirclesGridLayout& PatternGenerator::getLayout() const
+{
+	return layout;
+}
+
+std::vector<Point2f> PatternGenerator::getCenters(int patternId) const
+{
+	Point2f origin = gridOrigin(patternId);
+
+	std::vector<Point2f> centers;
+	for (int i = 0; i < layout.gridSize.height; ++i)
+	{
+		for (int j = 0; j < layout.gridSize.width; ++j)
+		{
+			centers.push_back(origin + Point2f((2 * j + i % 2) * layout.spacing, i * layout.spacing));
+		}
+	}
+	return centers;
+}
+
+Mat PatternGenerator::render(int patternId) const
+{
+	Mat pattern = Mat::zeros(layout.resolution, CV_8UC3);
+
+	// Coordinates with 4 fractional bits
+	const int shift = 4;
+	const float scale = 1 << shift;
+	for (const auto& c : getCenters(patternId))
+	{
+		circle(pattern, Point(cvRound(c.x * scale), cvRound(c.y * scale)), cvRound(layout.radius * scale), Scalar(255, 255, 255), FILLED, LINE_AA, shift);
+	}
+
+	return pattern;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+#include <opencv2/core.hpp>
+
+// Placement of an asymmetric circle grid that is moved over the projector, one pattern per placement
+struct CirclesGridLayout
+{
+	cv::Size resolution{ 1920, 1080 };
+	cv::Size gridSize{ 4, 9 };
+
+	// Distance between neighbouring rows, and half the distance between neighbouring circles in a row, in pixels
+	float spacing = 61.0f;
+	float radius = 20.0f;
+
+	// Number of grid positions along the width and height, spread evenly between the margins
+	cv::Size placements{ 3, 3 };
+	float margin = 20.0f;
+};
+
+// Renders circle grid patterns at the projector resolution in memory. The circles are drawn antialiased with 4 fractional
+// bits, so the centres are known to 1/16 pixel instead of detected in the pattern.
+class PatternGenerator
+{
+private:
+	CirclesGridLayout layout;
+
+	cv::Point2f gridOrigin(int patternId) const;
+
+public:
+	PatternGenerator(const CirclesGridLayout& layout);
+
+	int getNrPatterns() const;
+	const CirclesGridLayout& getLayout() const;
+
+	// Centres row by row, in the same layout as the object points of an asymmetric grid
+	std::vector<cv::Point2f> getCenters(int patternId) const;
+	cv::Mat render(int patternId) const;
+};
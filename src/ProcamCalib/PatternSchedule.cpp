@@ -0,0 +1,63 @@
+#include "PatternSchedule.h"
+#include <iostream>
+#include <opencv2/core.hpp>
+
+using namespace cv;
+
+PatternSchedule::PatternSchedule()
+{
+}
+
+bool PatternSchedule::fromFile(const std::string& fileName)
+{
+	FileStorage fs(fileName, FileStorage::READ + FileStorage::FORMAT_JSON);
+	if (!fs.isOpened())
+	{
+		std::cerr << "[PatternSchedule] Error: Could not open the input file " << fileName << std::endl;
+		return false;
+	}
+
+	intervals.clear();
+
+	// { "patterns": [ { "pattern": 0, "start": 0.5, "end": 4.0 }, ... ] }, "pattern" defaults to the position in the list
+	FileNode patterns = fs["patterns"];
+	int idx = 0;
+	for (auto it = patterns.begin(); it != patterns.end(); ++it, ++idx)
+	{
+		Interval interval;
+		interval.patternId = (*it)["pattern"].empty() ? idx : (int)(*it)["pattern"];
+		interval.start = (double)(*it)["start"];
+		interval.end = (double)(*it)["end"];
+		intervals.push_back(interval);
+	}
+	fs.release();
+
+	std::cout << "[PatternSchedule] Read " << intervals.size() << " pattern intervals from " << fileName << std::endl;
+	return !intervals.empty();
+}
+
+void PatternSchedule::uniform(int nrPatterns, double startTime, double endTime)
+{
+	intervals.clear();
+
+	double length = (endTime - startTime) / nrPatterns;
+	for (int i = 0; i < nrPatterns; ++i)
+	{
+		intervals.push_back(Interval{ i, startTime + i * length, startTime + (i + 1) * length });
+	}
+}
+
+int PatternSchedule::patternAt(double time) const
+{
+	for (const auto& interval : intervals)
+	{
+		if (time >= interval.start && time < interval.end)
+			return interval.patternId;
+	}
+	return -1;
+}
+
+bool PatternSchedule::empty() const
+{
+	return intervals.empty();
+}
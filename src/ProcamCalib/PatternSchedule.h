@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <vector>
+
+class PatternSchedule
+{
+private:
+	struct Interval
+	{
+		int patternId;
+		double start;
+		double end;
+	};
+
+	std::vector<Interval> intervals;
+
+public:
+	PatternSchedule();
+
+	bool fromFile(const std::string& fileName);
+	void uniform(int nrPatterns, double startTime, double endTime);
+
+	int patternAt(double time) const;
+	bool empty() const;
+};
+
@@ -0,0 +1,172 @@
+#include "PhaseShiftPattern.h"
+#include <cmath>
+#include <iostream>
+#include <opencv2/core.hpp>
+
+using namespace cv;
+
+PhaseShiftPattern::PhaseShiftPattern(const Size& resolution, int steps, int period, int periodRatio): resolution{resolution}, steps{steps}
+{
+	if (steps < 3 || period < 2 || periodRatio < 2)
+	{
+		std::cerr << "[PhaseShiftPattern] Needs at least 3 steps, a period of at least 2 pixels and a period ratio of at least 2" << std::endl;
+		exit(1);
+	}
+
+	colPeriods = periodsFor(resolution.width, period, periodRatio);
+	rowPeriods = periodsFor(resolution.height, period, periodRatio);
+}
+
+std::vector<int> PhaseShiftPattern::periodsFor(int length, int period, int periodRatio) const
+{
+	// From the coarsest period, which covers the whole axis, to the finest
+	std::vector<int> periods{ period };
+	while (periods.front() < length)
+	{
+		periods.insert(periods.begin(), periods.front() * periodRatio);
+	}
+	return periods;
+}
+
+std::vector<Mat> PhaseShiftPattern::generateAxis(const std::vector<int>& periods, bool columns) const
+{
+	std::vector<Mat> patterns;
+
+	int length = columns ? resolution.width : resolution.height;
+	Mat line(1, length, CV_8U);
+	for (int period : periods)
+	{
+		for (int n = 0; n < steps; ++n)
+		{
+			for (int x = 0; x < length; ++x)
+			{
+				double angle = 2 * CV_PI * x / period - 2 * CV_PI * n / steps;
+				line.at<uchar>(x) = saturate_cast<uchar>(127.5 + 127.5 * std::cos(angle));
+			}
+			patterns.push_back(columns ? repeat(line, resolution.height, 1) : repeat(line.t(), 1, resolution.width));
+		}
+	}
+
+	return patterns;
+}
+
+std::vector<Mat> PhaseShiftPattern::generate() const
+{
+	std::vector<Mat> patterns;
+	patterns.push_back(Mat(resolution, CV_8U, Scalar(255)));
+
+	std::vector<Mat> cols = generateAxis(colPeriods, true);
+	std::vector<Mat> rows = generateAxis(rowPeriods, false);
+	patterns.insert(patterns.end(), cols.begin(), cols.end());
+	patterns.insert(patterns.end(), rows.begin(), rows.end());
+
+	return patterns;
+}
+
+int PhaseShiftPattern::getNrPatterns() const
+{
+	return 1 + steps * (int)(colPeriods.size() + rowPeriods.size());
+}
+
+Size PhaseShiftPattern::getResolution() const
+{
+	return resolution;
+}
+
+void PhaseShiftPattern::decodeTile(const std::vector<Mat>& frames, int first, const std::vector<int>& periods, const Range& rows, Mat& coord, Mat& valid, int contrastThreshold) const
+{
+	Mat coordTile = coord.rowRange(rows);
+	Mat validTile = valid.rowRange(rows);
+
+	Mat frame, sinSum, cosSum, phi, amplitude, enough;
+	for (size_t k = 0; k < periods.size(); ++k)
+	{
+		// With I_n = A + B cos(phi - 2 pi n / steps), the sums are B steps / 2 times the sine and cosine of phi
+		sinSum = Mat::zeros(coordTile.size(), CV_32F);
+		cosSum = Mat::zeros(coordTile.size(), CV_32F);
+		for (int n = 0; n < steps; ++n)
+		{
+			frames[first + k * steps + n].rowRange(rows).convertTo(frame, CV_32F);
+			double shift = 2 * CV_PI * n / steps;
+			scaleAdd(frame, std::sin(shift), sinSum, sinSum);
+			scaleAdd(frame, std::cos(shift), cosSum, cosSum);
+		}
+
+		// Phase in [0, 2 pi)
+		phase(cosSum, sinSum, phi);
+
+		magnitude(cosSum, sinSum, amplitude);
+		compare(amplitude, contrastThreshold * steps / 2.0, enough, CMP_GE);
+		bitwise_and(validTile, enough, validTile);
+
+		float period = (float)periods[k];
+		float toPixels = period / (2 * (float)CV_PI);
+		if (k == 0)
+		{
+			phi.convertTo(coordTile, CV_32F, toPixels);
+			continue;
+		}
+
+		for (int y = 0; y < coordTile.rows; ++y)
+		{
+			const float* p = phi.ptr<float>(y);
+			float* c = coordTile.ptr<float>(y);
+			uchar* v = validTile.ptr<uchar>(y);
+			for (int x = 0; x < coordTile.cols; ++x)
+			{
+				float wrapped = p[x] * toPixels;
+				float unwrapped = wrapped + period * cvRound((c[x] - wrapped) / period);
+
+				// A coarser coordinate that is far off means the coarser phase was too noisy
+				if (std::fabs(unwrapped - c[x]) > 0.25f * period)
+					v[x] = 0;
+				c[x] = unwrapped;
+			}
+		}
+	}
+}
+
+bool PhaseShiftPattern::decode(const std::vector<Mat>& frames, Mat& projCoords, Mat& valid, int contrastThreshold) const
+{
+	if ((int)frames.size() != getNrPatterns())
+	{
+		std::cerr << "[PhaseShiftPattern] Expected " << getNrPatterns() << " frames, got " << frames.size() << std::endl;
+		return false;
+	}
+
+	for (const auto& frame : frames)
+	{
+		if (frame.type() != CV_8UC1 || frame.size() != frames[whiteFrame].size())
+		{
+			std::cerr << "[PhaseShiftPattern] Frames should be grayscale and of the same size" << std::endl;
+			return false;
+		}
+	}
+
+	Size size = frames[whiteFrame].size();
+	valid = Mat(size, CV_8U, Scalar(255));
+	Mat colCoord(size, CV_32F), rowCoord(size, CV_32F);
+
+	int colFirst = 1;
+	int rowFirst = colFirst + steps * (int)colPeriods.size();
+	int nrTiles = (size.height + tileRows - 1) / tileRows;
+	parallel_for_(Range(0, nrTiles), [&](const Range& tiles)
+	{
+		for (int t = tiles.start; t < tiles.end; ++t)
+		{
+			Range rows(t * tileRows, std::min((t + 1) * tileRows, size.height));
+			decodeTile(frames, colFirst, colPeriods, rows, colCoord, valid, contrastThreshold);
+			decodeTile(frames, rowFirst, rowPeriods, rows, rowCoord, valid, contrastThreshold);
+		}
+	});
+
+	// The coarsest period is longer than the projector, phases past the border are noise
+	Mat inside;
+	compare(colCoord, resolution.width, inside, CMP_LT);
+	bitwise_and(valid, inside, valid);
+	compare(rowCoord, resolution.height, inside, CMP_LT);
+	bitwise_and(valid, inside, valid);
+
+	merge(std::vector<Mat>{ colCoord, rowCoord }, projCoords);
+	return true;
+}
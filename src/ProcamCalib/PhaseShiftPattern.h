@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include <opencv2/core.hpp>
+#include "StructuredLightPattern.h"
+
+// Sinusoidal phase shift structured light. The sequence is a white frame followed, for both axes and from the coarsest to
+// the finest period, by steps frames of a sinusoid with the given period shifted by 1/steps of a period each time.
+// The coarsest period covers the whole projector so its phase is unambiguous, every finer period is unwrapped with the
+// coordinate of the previous one. Periods grow by periodRatio. The unwrapping only picks the right period while the
+// coordinate error of the coarser period stays below half of the finer period, so the camera's phase noise bounds the ratio.
+class PhaseShiftPattern : public StructuredLightPattern
+{
+private:
+	cv::Size resolution;
+	int steps;
+	std::vector<int> colPeriods;
+	std::vector<int> rowPeriods;
+
+	// Rows decoded at once per thread, bounds the size of the intermediate buffers
+	static const int tileRows = 32;
+
+	std::vector<int> periodsFor(int length, int period, int periodRatio) const;
+	std::vector<cv::Mat> generateAxis(const std::vector<int>& periods, bool columns) const;
+	void decodeTile(const std::vector<cv::Mat>& frames, int first, const std::vector<int>& periods, const cv::Range& rows, cv::Mat& coord, cv::Mat& valid, int contrastThreshold) const;
+
+public:
+	PhaseShiftPattern(const cv::Size& resolution, int steps = 4, int period = 16, int periodRatio = 8);
+
+	std::vector<cv::Mat> generate() const override;
+	int getNrPatterns() const override;
+	cv::Size getResolution() const override;
+	bool decode(const std::vector<cv::Mat>& frames, cv::Mat& projCoords, cv::Mat& valid, int contrastThreshold = 10) const override;
+};
@@ -1,9 +1,15 @@
 #include <iostream>
 #include <vector>
 #include "Projector.h"
+#include "GrayCodePattern.h"
+#include "PhaseShiftPattern.h"
+#include "PatternGenerator.h"
 #include "ProcamCalibrator.h"
+#include "DetectorPool.h"
+#include "MultiProcamCalibrator.h"
 #include "DeviceFactory/DeviceFactory.h"
 #include <filesystem>
+#include <memory>
 
 using namespace std;
 
@@ -27,22 +33,60 @@ public:
 };
 
 
+// Parses {width}x{height}
+bool parseSize(const std::string& str, cv::Size& size)
+{
+    size_t separator = str.find('x');
+    if (separator == std::string::npos)
+        return false;
+    size = cv::Size(std::stoi(str.substr(0, separator)), std::stoi(str.substr(separator + 1)));
+    return true;
+}
 
 int main(int argc, char** argv)
 {
     CmdLineParser cml(argc, argv);
     if (argc < 3 || cml["-h"]) {
-        cerr << std::endl << "Usage: ./ProcamCalib recording patterns camcalib mirrorcalib [-p] [-camid] [-d]" << std::endl;
+        cerr << std::endl << "Usage: ./ProcamCalib recording patterns camcalib mirrorcalib [-p] [-camid] [-video] [-d]" << std::endl;
         cerr << std::endl << "recording: folder containing the recording, or folder to save images to. Starts with 'S' if recording is mirrored." << std::endl;
-        cerr << std::endl << "patterns: folder containing the patterns, folder name should end with _{width}_{height} of the circlegrid to detect." << std::endl;
+        cerr << std::endl << "patterns: folder containing the patterns, folder name should end with _{width}_{height} of the circlegrid to detect. With [-generate], [-graycode] or [-phaseshift] the projector resolution as {width}x{height}." << std::endl;
         cerr << std::endl << "camcalib: path to camera calibration data." << std::endl;
         cerr << std::endl << "[--mirrorcalib]: path to mirror calibration data. Only needed when using a mirrored recording (S...)." << std::endl;
-        cerr << std::endl << "[-p]: captures per pattern, only use when physical camera is connected." << std::endl;
+        cerr << std::endl << "[-p]: captures per pattern, or board poses with [-graycode] or [-phaseshift]. Only use when physical camera is connected." << std::endl;
         cerr << std::endl << "[-camid]: camera id to use. Only use when physical camera is connected." << std::endl;
+        cerr << std::endl << "[-gray]: decode images, video frames and camera captures directly to grayscale." << std::endl;
+        cerr << std::endl << "[-pack]: save captures to a single packed recording file instead of separate images. Only use when physical camera is connected." << std::endl;
+        cerr << std::endl << "[-format]: image format of the captures, png, bmp or tiff. Defaults to png. [-compression]: PNG compression level from 0 to 9, defaults to 1. Neither applies to [-pack], packed captures are stored raw. Captures are written in the background." << std::endl;
+        cerr << std::endl << "[-video]: video file to calibrate from instead of the images in the recording folder." << std::endl;
+        cerr << std::endl << "[-stride]: use every n-th video frame. [-start] [-end]: time range of the video to use, in seconds. [-keyframes]: only use key frames." << std::endl;
+        cerr << std::endl << "[-patternmap]: JSON file with the time range of each pattern in the video. Without it the video is divided evenly over the patterns." << std::endl;
+        cerr << std::endl << "[-proj]: name or name=patterns of a projector, repeat for every projector. The captures of each projector are in recording/name, patterns defaults to the patterns argument. Results are saved as {recording}_{name}.json." << std::endl;
+        cerr << std::endl << "[-threads]: number of projectors calibrated at the same time with [-proj], defaults to the number of cores." << std::endl;
+        cerr << std::endl << "[-generate]: render circle grid patterns at the projector resolution instead of loading them. [-grid]: circles per row x rows, defaults to 4x9. [-spacing] [-radius]: row spacing and circle radius in pixels, default to 1/18 and 1/54 of the height. [-placements]: grid positions along the width x height, defaults to 3x3." << std::endl;
+        cerr << std::endl << "[-graycode]: project generated Gray code and line shift patterns instead of circle grids, every board pose gives a correspondence for every few camera pixels on the board." << std::endl;
+        cerr << std::endl << "[-lineshift]: number of line shift patterns per axis with [-graycode], a power of two. Defaults to 8, 1 only uses the Gray codes." << std::endl;
+        cerr << std::endl << "[-phaseshift]: project generated sinusoidal phase shift patterns instead of circle grids, decoded to subpixel projector coordinates for every few camera pixels on the board." << std::endl;
+        cerr << std::endl << "[-steps]: phase shifts per period with [-phaseshift], at least 3. Defaults to 4. [-period]: finest period in projector pixels, defaults to 16." << std::endl;
+        cerr << std::endl << "[-corr]: file to save the detected correspondences to. When it exists the detections are read from it instead, and a live session continues after the captures it holds." << std::endl;
+        cerr << std::endl << "[-track]: track the board between live frames and only run the full detection when the board is in view. Only use when physical camera is connected." << std::endl;
+        cerr << std::endl << "[-reject]: views with a stereo error more than this many (normalized) median absolute deviations above the median are left out and the calibration is solved again. Defaults to 3, 0 keeps every view." << std::endl;
+        cerr << std::endl << "[-maxviews]: keep at most this many views in memory, spread over the positions and sizes of the board in the image, for very long recordings. Defaults to 0, every view is kept." << std::endl;
+        cerr << std::endl << "[-uncertainty]: estimate the standard deviation of the calibration from resamples of the views, bootstrap or loo (leave one out). Saved next to the calibration. [-resamples]: number of resamples, defaults to 100." << std::endl;
+        cerr << std::endl << "[-preset]: detection preset, realtime, default or precise. Defaults to default." << std::endl;
+        cerr << std::endl << "[-dbgout]: write the detections with overlays to a folder of images, or to a video when the path ends with .avi, .mp4 or .mkv. Does not need a display." << std::endl;
         cerr << std::endl << "[-d]: whether to use debug mode or not." << std::endl;
         return 0;
     }
 
+    Uncertainty::Method uncertainty;
+    if (!Uncertainty::parse(cml("-uncertainty", "none"), uncertainty))
+        exit(1);
+
+    DetectionPreset::Type preset;
+    if (!DetectionPreset::parse(cml("-preset", "default"), preset))
+        exit(1);
+    DetectorPool::global().setPreset(preset);
+
     std::string recordingFolder = argv[1];
     std::string patterns = argv[2];
     std::string camCalibPath = argv[3];
@@ -55,24 +99,145 @@ int main(int argc, char** argv)
         exit(1);
     }
 
-    Projector proj{ patterns };
+    std::vector<std::string> projectorArgs = cml.getAllInstances("-proj");
+    if (!projectorArgs.empty())
+    {
+        if (cml["-video"] || cml["-p"] || cml["-camid"] || cml["-d"] || cml["-generate"] || cml["-graycode"] || cml["-phaseshift"])
+        {
+            cerr << "[ProcamCalib]: [-proj] only supports calibrating from recordings, without [-video], [-p], [-camid], [-d], [-generate], [-graycode] or [-phaseshift]" << endl;
+            exit(1);
+        }
+
+        MultiProcamCalibrator multiCalibrator;
+        multiCalibrator.init(recordingFolder, cml("--mirrorcalib"), camCalibPath);
+
+        for (const auto& arg : projectorArgs)
+        {
+            size_t separator = arg.find('=');
+            if (separator == std::string::npos)
+                multiCalibrator.addProjector(arg, patterns);
+            else
+                multiCalibrator.addProjector(arg.substr(0, separator), arg.substr(separator + 1));
+        }
+
+        multiCalibrator.setGrayscale(cml["-gray"]);
+        multiCalibrator.setMaxThreads(std::stoi(cml("-threads", "0")));
+        if (cml["-dbgout"])
+            multiCalibrator.setDebugOutput(cml("-dbgout"));
+
+        multiCalibrator.calibrate();
+        if (!multiCalibrator.saveToJSON())
+            exit(1);
+
+        return 0;
+    }
+
+    std::unique_ptr<Projector> proj;
+    cv::Size resolution;
+    if ((cml["-generate"] || cml["-graycode"] || cml["-phaseshift"]) && !parseSize(patterns, resolution))
+    {
+        cerr << "[ProcamCalib]: the projector resolution should be given as {width}x{height} with [-generate], [-graycode] or [-phaseshift]" << endl;
+        exit(1);
+    }
+
+    if (cml["-generate"])
+    {
+        CirclesGridLayout layout;
+        layout.resolution = resolution;
+        layout.spacing = std::stof(cml("-spacing", std::to_string(resolution.height / 18.0f)));
+        layout.radius = std::stof(cml("-radius", std::to_string(resolution.height / 54.0f)));
+        if (!parseSize(cml("-grid", "4x9"), layout.gridSize) || !parseSize(cml("-placements", "3x3"), layout.placements))
+        {
+            cerr << "[ProcamCalib]: [-grid] and [-placements] should be given as {width}x{height}" << endl;
+            exit(1);
+        }
+        proj = std::make_unique<Projector>(layout);
+    }
+    else if (cml["-graycode"] || cml["-phaseshift"])
+    {
+        if (cml["-video"])
+        {
+            cerr << "[ProcamCalib]: [-graycode] and [-phaseshift] do not support [-video]" << endl;
+            exit(1);
+        }
+
+        std::shared_ptr<StructuredLightPattern> structuredLight;
+        if (cml["-phaseshift"])
+            structuredLight = std::make_shared<PhaseShiftPattern>(resolution, std::stoi(cml("-steps", "4")), std::stoi(cml("-period", "16")));
+        else
+            structuredLight = std::make_shared<GrayCodePattern>(resolution, std::stoi(cml("-lineshift", "8")));
+        proj = std::make_unique<Projector>(structuredLight);
+    }
+    else
+    {
+        proj = std::make_unique<Projector>(patterns);
+    }
+
     ProcamCalibrator calibrator;
 
     if (cml["--mirrorcalib"])
     {
         mirrorRecordingFolder = cml("--mirrorcalib");
-        calibrator.init(recordingFolder, mirrorRecordingFolder, &proj, camCalibPath);
+        if (!calibrator.init(recordingFolder, mirrorRecordingFolder, proj.get(), camCalibPath))
+            exit(1);
     }
-    else
+    else if (!calibrator.init(recordingFolder, proj.get(), camCalibPath))
     {
-        calibrator.init(recordingFolder, &proj, camCalibPath);
+        exit(1);
     }
 
-    if (cml["-p"] && cml["-camid"])
+    calibrator.setPackCaptures(cml["-pack"]);
+    if (!calibrator.setCaptureFormat(cml("-format", "png"), std::stoi(cml("-compression", "1"))))
+        exit(1);
+    calibrator.setGrayscale(cml["-gray"]);
+    if (cml["-dbgout"])
+        calibrator.setDebugOutput(cml("-dbgout"));
+    calibrator.setTracking(cml["-track"]);
+    calibrator.setMaxViews(std::stoi(cml("-maxviews", "0")));
+    calibrator.setOutlierRejection(std::stod(cml("-reject", "3")));
+    if (cml["-corr"])
+        calibrator.setCorrespondenceFile(cml("-corr"));
+
+    if (cml["-video"])
     {
+        VideoSampling sampling;
+        sampling.stride = std::stoi(cml("-stride", "1"));
+        sampling.startTime = std::stod(cml("-start", "0"));
+        sampling.endTime = std::stod(cml("-end", "-1"));
+        sampling.keyframesOnly = cml["-keyframes"];
+        sampling.grayscale = cml["-gray"];
+
+        VideoFrameSource video;
+        if (!video.open(cml("-video"), sampling))
+            exit(1);
+
+        PatternSchedule schedule;
+        if (cml["-patternmap"])
+        {
+            if (!schedule.fromFile(cml("-patternmap")))
+                exit(1);
+        }
+        else
+        {
+            if (video.getEndTime() < 0)
+            {
+                cerr << "[ProcamCalib]: Video length unknown, use [-end] or [-patternmap]" << endl;
+                exit(1);
+            }
+            schedule.uniform(proj->getNrPatterns(), video.getStartTime(), video.getEndTime());
+        }
+
+        calibrator.calibrate(video, schedule, cml["-d"]);
+    }
+    else if (cml["-p"] && cml["-camid"])
+    {
+        DeviceFactory::DeviceProperties properties;
+        if (cml["-gray"])
+            properties["grayscale"] = "1";
+
         DeviceFactory::DeviceFactory df;
         df.listAvailableDevices();
-        std::shared_ptr<DeviceFactory::Device> cam = df.createDevices("RealSense2", cml("-camid"));
+        std::shared_ptr<DeviceFactory::Device> cam = df.createDevices("RealSense2", cml("-camid"), properties);
         if(cam.get() == nullptr)
             exit(1);
         calibrator.calibrate(cam, std::stoi(cml("-p")));
@@ -88,7 +253,9 @@ int main(int argc, char** argv)
         exit(1);
     }
 
-    calibrator.saveToJSON();
+    calibrator.estimateUncertainty(uncertainty, std::stoi(cml("-resamples", "100")));
+    if (!calibrator.saveToJSON())
+        exit(1);
 
     return 0;
 }
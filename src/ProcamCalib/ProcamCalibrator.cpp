@@ -1,66 +1,52 @@
 #include "ProcamCalibrator.h"
+#include <algorithm>
 #include <filesystem>
+#include <numeric>
 #include <opencv2/core.hpp>
 #include "Config.h"
 #include "Utils.h"
-#include <sstream>
 
 using namespace cv;
 
-std::vector<Point3f> ProcamCalibrator::pointsToBoardSpace(std::vector<Point2f> points2d, std::vector<Point2f> refPoints2d, std::vector<Point3f> objp, Matx33d cameraIntrinsics, std::vector<double> distortionCoeffs)
+std::vector<Point3f> ProcamCalibrator::pointsToBoardSpace(const std::vector<Point2f>& points2d, const std::vector<Point2f>& refPoints2d, const Matx33d& cameraIntrinsics, const std::vector<double>& distortionCoeffs)
 {
-	std::vector<Point2f> undistortedPoints2d;
-	undistortPoints(points2d, undistortedPoints2d, cameraIntrinsics, distortionCoeffs, noArray(), cameraIntrinsics);
+	undistortPoints(refPoints2d, undistortedPoints, cameraIntrinsics, distortionCoeffs, noArray(), cameraIntrinsics);
+	Mat H = findHomography(undistortedPoints, objpPlanar);
 
-	std::vector<Point2f> undistortedRefPoints2d;
-	undistortPoints(refPoints2d, undistortedRefPoints2d, cameraIntrinsics, distortionCoeffs, noArray(), cameraIntrinsics);
-
-	std::vector<Point2f> objpPlanar;
-	for (auto p : objp)
-	{
-		objpPlanar.push_back(Point2f{ p.x, p.y });
-	}
-
-	Mat H = findHomography(undistortedRefPoints2d, objpPlanar);
-	
-	std::vector<Point2f> transformedPoints2d;
-	perspectiveTransform(undistortedPoints2d, transformedPoints2d, H);
+	// The homography with an added zero row maps the image points straight to board points with z = 0
+	Mat toBoard = Mat::zeros(4, 3, CV_64F);
+	H.rowRange(0, 2).copyTo(toBoard.rowRange(0, 2));
+	H.row(2).copyTo(toBoard.row(3));
 
+	undistortPoints(points2d, undistortedPoints, cameraIntrinsics, distortionCoeffs, noArray(), cameraIntrinsics);
 	std::vector<Point3f> points3d;
-	for (auto p : transformedPoints2d)
-	{
-		points3d.push_back(Point3f{ p.x, p.y, 0 });
-	}
+	perspectiveTransform(undistortedPoints, points3d, toBoard);
 
 	return points3d;
 }
 
-bool ProcamCalibrator::detectAll(Mat pattern, Mat img, bool mirrored, int debugDelay)
+bool ProcamCalibrator::detectAll(int id, Mat pattern, Mat img, bool mirrored, int debugDelay)
 {
-	std::vector<Point2f> circlesPattern;
-	bool retPattern = findCirclesGrid(pattern, circlesGridSize, circlesPattern, (CALIB_CB_ASYMMETRIC_GRID + CALIB_CB_CLUSTERING), circlesDetector);
+	std::vector<Point2f> circlesPattern = proj->findCurrentCircles(circlesDetector);
+	if (circlesPattern.empty())
+		return false;
 
 	if (mirrored)
 	{
 		Utils::flip2dPoints(circlesPattern, pattern.cols);
 	}
 
-	Mat gray;
-	cvtColor(img, gray, COLOR_BGR2GRAY);
-	if (mirrored)
-	{
-		flip(gray, gray, 1);
-	}
-
-	Mat grayB;
-	GaussianBlur(gray, grayB, Size(3, 3), 1);
-
+	// Grayscale conversion, mirroring and blur in one pass into buffers that are reused for every frame
+	preprocessor.process(img, mirrored);
+	const Mat& gray = preprocessor.getGray();
+	const Mat& grayB = preprocessor.getBlurred();
 
 	std::vector<Point2f> circlesFrame;
 	bool retFrame = findCirclesGrid(grayB, circlesGridSize, circlesFrame, (CALIB_CB_ASYMMETRIC_GRID + CALIB_CB_CLUSTERING), circlesDetector);
 	if (retFrame == false || circlesFrame.size() <= 0)
 	{
 		std::cout << "!!!! Failed to find the circle grid !!!!" << std::endl;
+		debugSink.submit("nogrid", img);
 		return false;
 	}
 
@@ -73,7 +59,7 @@ bool ProcamCalibrator::detectAll(Mat pattern, Mat img, bool mirrored, int debugD
 
 	std::vector<Point2f> corners;
 	std::vector<int> ids;
-	detector.detectCharucoCorners(gray, corners, ids);
+	detector->detectCharucoCorners(gray, corners, ids);
 	if (corners.size() >= 35)
 	{
 		std::cout << "-- Charuco detected" << std::endl;
@@ -83,15 +69,23 @@ bool ProcamCalibrator::detectAll(Mat pattern, Mat img, bool mirrored, int debugD
 			Utils::flip2dPoints(corners, gray.cols);
 		}
 
-		std::vector<Point3f> circles3d = pointsToBoardSpace(circlesFrame, corners, objp, camCalib.getIntrinsicsMatrix(), camCalib.getDistortionParameters());
+		std::vector<Point3f> circles3d = pointsToBoardSpace(circlesFrame, corners, camCalib.getIntrinsicsMatrix(), camCalib.getDistortionParameters());
+
+		debugSink.submit("detected", img, { DebugOverlay::corners(circlesGridSize, circlesFrame), DebugOverlay::corners(detector->getBoardSize(), corners) });
 
 		if (debugDelay >= 0)
 		{
+			// img can be a read only frame of a packed recording
+			Mat shown;
+			if (img.channels() == 1)
+				cvtColor(img, shown, COLOR_GRAY2BGR);
+			else
+				shown = img.clone();
 
-			drawChessboardCorners(img, circlesGridSize, circlesFrame, true);
-			drawChessboardCorners(img, detector.getBoardSize(), corners, true);
+			drawChessboardCorners(shown, circlesGridSize, circlesFrame, true);
+			drawChessboardCorners(shown, detector->getBoardSize(), corners, true);
 
-			imshow("Camera", img);
+			imshow("Camera", shown);
 			auto c = waitKey(debugDelay);
 			if (c == 'q')
 			{
@@ -104,23 +98,204 @@ bool ProcamCalibrator::detectAll(Mat pattern, Mat img, bool mirrored, int debugD
 			}
 		}
 
-		objPointsVirtual.push_back(circles3d);
-		imgPointsVirtualProj.push_back(circlesPattern);
-		imgPointsCamera.push_back(circlesFrame);
+		addView(id, Mat(circles3d), Mat(circlesPattern), Mat(circlesFrame), img.size());
+
+		if (correspondenceWriter.isOpened())
+			correspondenceWriter.write(id, img.size(), { Mat(circles3d), Mat(circlesPattern), Mat(circlesFrame) });
 
 		return true;
 	}
 	else
 	{
 		std::cout << "!!!! Failed to find charuco board !!!!" << std::endl;
+		debugSink.submit("nocharuco", img, { DebugOverlay::corners(circlesGridSize, circlesFrame) });
+		return false;
+	}
+}
+
+bool ProcamCalibrator::detectStructuredLight(int pose, const std::vector<Mat>& frames, bool mirrored, int debugDelay)
+{
+	const Mat& white = frames[StructuredLightPattern::whiteFrame];
+
+	preprocessor.process(white, mirrored);
+	const Mat& gray = preprocessor.getGray();
+
+	std::vector<Point2f> corners;
+	std::vector<int> ids;
+	detector->detectCharucoCorners(gray, corners, ids);
+	if (corners.size() < 35)
+	{
+		std::cout << "!!!! Failed to find charuco board !!!!" << std::endl;
+		debugSink.submit("nocharuco", white);
+		return false;
+	}
+
+	if (mirrored)
+	{
+		Utils::flip2dPoints(corners, gray.cols);
+	}
+
+	std::cout << "-- Charuco detected" << std::endl;
+
+	// The codes are decoded in the unmirrored frames, the projector coordinates do not depend on the camera image
+	std::vector<Mat> grayFrames(frames.size());
+	for (size_t i = 0; i < frames.size(); ++i)
+	{
+		Utils::toGray(frames[i], grayFrames[i]);
+	}
+
+	Mat projCoords, valid;
+	if (!proj->getStructuredLight().decode(grayFrames, projCoords, valid))
+		return false;
+
+	std::vector<Point2f> framePoints, patternPoints;
+	Rect boardRect = boundingRect(corners) & Rect(0, 0, valid.cols, valid.rows);
+	for (int y = boardRect.y; y < boardRect.y + boardRect.height; y += structuredLightStep)
+	{
+		const uchar* v = valid.ptr<uchar>(y);
+		const Vec2f* p = projCoords.ptr<Vec2f>(y);
+		for (int x = boardRect.x; x < boardRect.x + boardRect.width; x += structuredLightStep)
+		{
+			if (v[x])
+			{
+				framePoints.push_back(Point2f((float)x, (float)y));
+				patternPoints.push_back(Point2f(p[x][0], p[x][1]));
+			}
+		}
+	}
+
+	if (framePoints.empty())
+	{
+		std::cout << "!!!! Failed to decode the structured light !!!!" << std::endl;
+		debugSink.submit("nodecode", white, { DebugOverlay::corners(detector->getBoardSize(), corners) });
+		return false;
+	}
+
+	// The bounding box of the corners also holds pixels next to the board, these do not lie on the board plane
+	std::vector<Point3f> points3d = pointsToBoardSpace(framePoints, corners, camCalib.getIntrinsicsMatrix(), camCalib.getDistortionParameters());
+	const Point3f& boardEnd = objp.back();
+
+	std::vector<Point3f> boardPoints3d;
+	std::vector<Point2f> boardFramePoints, boardPatternPoints;
+	for (size_t i = 0; i < points3d.size(); ++i)
+	{
+		if (points3d[i].x < 0 || points3d[i].y < 0 || points3d[i].x > boardEnd.x || points3d[i].y > boardEnd.y)
+			continue;
+
+		boardPoints3d.push_back(points3d[i]);
+		boardFramePoints.push_back(framePoints[i]);
+		boardPatternPoints.push_back(patternPoints[i]);
+	}
+
+	if (boardPoints3d.size() < objp.size())
+	{
+		std::cout << "!!!! Too few decoded points on the board !!!!" << std::endl;
+		debugSink.submit("nodecode", white, { DebugOverlay::corners(detector->getBoardSize(), corners) });
 		return false;
 	}
+
+	if (mirrored)
+	{
+		Utils::flip2dPoints(boardPatternPoints, proj->getStructuredLight().getResolution().width);
+	}
+
+	std::cout << "-- Decoded " << boardPoints3d.size() << " points on the board" << std::endl;
+
+	debugSink.submit("detected", white, { DebugOverlay::corners(detector->getBoardSize(), corners) });
+
+	if (debugDelay >= 0)
+	{
+		Mat img;
+		if (white.channels() == 1)
+			cvtColor(white, img, COLOR_GRAY2BGR);
+		else
+			img = white.clone();
+
+		for (const auto& p : boardFramePoints)
+		{
+			circle(img, p, 1, Scalar(0, 255, 0), FILLED);
+		}
+		drawChessboardCorners(img, detector->getBoardSize(), corners, true);
+
+		imshow("Camera", img);
+		auto c = waitKey(debugDelay);
+		if (c == 'q')
+		{
+			destroyAllWindows();
+			exit(1);
+		}
+		else if (c == 's')
+		{
+			return false;
+		}
+	}
+
+	addView(pose, Mat(boardPoints3d), Mat(boardPatternPoints), Mat(boardFramePoints), white.size());
+
+	if (correspondenceWriter.isOpened())
+		correspondenceWriter.write(pose, white.size(), { Mat(boardPoints3d), Mat(boardPatternPoints), Mat(boardFramePoints) });
+
+	return true;
+}
+
+int ProcamCalibrator::loadCorrespondences()
+{
+	CorrespondenceStore store;
+	if (correspondenceFile.empty() || !store.open(correspondenceFile, { 3, 2, 2 }))
+		return 0;
+
+	// Captures forced without a detection are stored as empty views, they only keep their id
+	int nextId = 0;
+	for (int i = 0; i < store.size(); ++i)
+	{
+		nextId = std::max(nextId, store.getId(i) + 1);
+
+		Mat boardPoints = store.getPoints(i, 0);
+		if (boardPoints.empty())
+			continue;
+
+		frameSize = store.getFrameSize(i);
+		addView(store.getId(i), boardPoints, store.getPoints(i, 1), store.getPoints(i, 2), frameSize);
+		++detections;
+	}
+
+	// The projector resolution is taken from the current pattern
+	if (proj->getCurrentPatternId() < 0)
+		proj->setPattern(0);
+
+	std::cout << "[ProcamCalibrator] Loaded " << store.size() << " views from " << correspondenceFile << std::endl;
+	return nextId;
+}
+
+void ProcamCalibrator::addView(int id, const Mat& boardPoints, const Mat& patternPoints, const Mat& framePoints, const Size& frameSize)
+{
+	int slot = reservoir.offer(framePoints, frameSize);
+	if (slot < 0)
+		return;
+
+	views.store(slot, { boardPoints, patternPoints, framePoints });
+	if (slot == (int)viewIds.size())
+		viewIds.push_back(id);
+	else
+		viewIds[slot] = id;
 }
 
 void ProcamCalibrator::calibrateInternal(bool mirrored, const Size& projSize, const Size& camSize)
 {
+	reservoir.printSummary(std::cout);
+
+	// Rejection only picks the views of this solve, the arena keeps every view for the next one
+	keptViews.resize(views.size());
+	std::iota(keptViews.begin(), keptViews.end(), 0);
+	rejectedViews.clear();
+	rejectedErrors.clear();
+
+	std::vector<Mat> boardPoints = views.getSet(0, keptViews);
+	std::vector<Mat> patternPoints = views.getSet(1, keptViews);
+	std::vector<Mat> framePoints = views.getSet(2, keptViews);
+
 	Mat _rvecs, _tvecs;
-	projRMS = cv::calibrateCamera(objPointsVirtual, imgPointsVirtualProj, projSize, projInt, projDist, _rvecs, _tvecs, 0, TermCriteria(TermCriteria::COUNT + TermCriteria::EPS, 1e6, DBL_EPSILON));
+	projRMS = cv::calibrateCamera(boardPoints, patternPoints, projSize, projInt, projDist, _rvecs, _tvecs, 0, TermCriteria(TermCriteria::COUNT + TermCriteria::EPS, 1e6, DBL_EPSILON));
 
 	std::cout << camCalib;
 	std::cout << std::endl << "Projector\n----------------\nRMS: " << projRMS << std::endl << "Intrinsics:" << std::endl << projInt << std::endl;
@@ -129,8 +304,93 @@ void ProcamCalibrator::calibrateInternal(bool mirrored, const Size& projSize, co
 	Matx33d R;
 	Matx31d T;
 	Mat E, F, rvecs, tvecs, perViewErrors;
-	stereoRMS = cv::stereoCalibrate(objPointsVirtual, imgPointsVirtualProj, imgPointsCamera, projInt, projDist, camCalib.getIntrinsicsMatrix(), camCalib.getDistortionParameters(), camSize, R, T, E, F, perViewErrors, 256, TermCriteria(TermCriteria::COUNT + TermCriteria::EPS, 1e2, DBL_EPSILON));
+	stereoRMS = cv::stereoCalibrate(boardPoints, patternPoints, framePoints, projInt, projDist, camCalib.getIntrinsicsMatrix(), camCalib.getDistortionParameters(), camSize, R, T, E, F, perViewErrors, CALIB_FIX_INTRINSIC, TermCriteria(TermCriteria::COUNT + TermCriteria::EPS, 1e2, DBL_EPSILON));
+
+	// Views the solution does not explain are left out, every round is warm started from the previous one
+
+	for (int round = 0; round < maxRejectionRounds; ++round)
+	{
+		std::vector<int> outliers = findOutlierViews(perViewErrors);
+		if (outliers.empty())
+			break;
+
+		std::cout << "[ProcamCalibrator] Rejecting views";
+		for (int v : outliers)
+		{
+			double error = std::max(perViewErrors.at<double>(v, 0), perViewErrors.at<double>(v, 1));
+			std::cout << " " << viewIds[keptViews[v]] << " (" << error << ")";
+			rejectedViews.push_back(viewIds[keptViews[v]]);
+			rejectedErrors.push_back(error);
+		}
+		std::cout << std::endl;
+
+		for (auto it = outliers.rbegin(); it != outliers.rend(); ++it)
+			keptViews.erase(keptViews.begin() + *it);
+		boardPoints = views.getSet(0, keptViews);
+		patternPoints = views.getSet(1, keptViews);
+		framePoints = views.getSet(2, keptViews);
+
+		projRMS = cv::calibrateCamera(boardPoints, patternPoints, projSize, projInt, projDist, _rvecs, _tvecs, CALIB_USE_INTRINSIC_GUESS, TermCriteria(TermCriteria::COUNT + TermCriteria::EPS, 1e2, DBL_EPSILON));
+		stereoRMS = cv::stereoCalibrate(boardPoints, patternPoints, framePoints, projInt, projDist, camCalib.getIntrinsicsMatrix(), camCalib.getDistortionParameters(), camSize, R, T, E, F, perViewErrors, CALIB_FIX_INTRINSIC | CALIB_USE_EXTRINSIC_GUESS, TermCriteria(TermCriteria::COUNT + TermCriteria::EPS, 1e2, DBL_EPSILON));
+	}
+
+	std::cout << std::endl << "Per view stereo errors (projector, camera):" << std::endl;
+	for (int i = 0; i < perViewErrors.rows; ++i)
+		std::cout << "  " << viewIds[keptViews[i]] << ": " << perViewErrors.at<double>(i, 0) << ", " << perViewErrors.at<double>(i, 1) << std::endl;
+	if (!rejectedViews.empty())
+		std::cout << "Rejected " << rejectedViews.size() << " of " << views.size() << " views, projector RMS: " << projRMS << std::endl;
+	viewErrors = perViewErrors;
+
+	cam2Proj = toCam2Proj(R, T, mirrored, virtualProj2Cam);
+
+	stereoR = R;
+	stereoT = T;
+	this->projSize = projSize;
+	this->mirrored = mirrored;
+	frameSize = camSize;
+
+	std::cout << std::endl << "Stereo\n----------------\nRMS: " << stereoRMS << std::endl << "Cam2Proj:" << std::endl << cam2Proj << std::endl;
+}
 
+std::vector<int> ProcamCalibrator::findOutlierViews(const Mat& perViewErrors) const
+{
+	std::vector<int> outliers;
+	if (rejectionThreshold <= 0)
+		return outliers;
+
+	// A view is as bad as the worst of its projector and camera errors
+	std::vector<double> errors(perViewErrors.rows);
+	for (int i = 0; i < perViewErrors.rows; ++i)
+		errors[i] = std::max(perViewErrors.at<double>(i, 0), perViewErrors.at<double>(i, 1));
+
+	auto median = [](std::vector<double> values)
+	{
+		std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+		return values[values.size() / 2];
+	};
+
+	double med = median(errors);
+	std::vector<double> deviations(errors.size());
+	for (size_t i = 0; i < errors.size(); ++i)
+		deviations[i] = std::abs(errors[i] - med);
+
+	// 1.4826 scales the MAD to the standard deviation of normally distributed errors
+	double threshold = med + rejectionThreshold * 1.4826 * median(deviations);
+	for (size_t i = 0; i < errors.size(); ++i)
+	{
+		if (errors[i] > threshold)
+			outliers.push_back(i);
+	}
+
+	// Enough views have to stay to solve the projector intrinsics
+	if (errors.size() - outliers.size() < 3)
+		outliers.clear();
+
+	return outliers;
+}
+
+Matx44d ProcamCalibrator::toCam2Proj(const Matx33d& R, const Matx31d& T, bool mirrored, Matx44d& virtualProj2Cam)
+{
 	Matx44d projCalib = Utils::extrinsicFromRt(R, T);
 	
 	if (mirrored)
@@ -148,65 +408,106 @@ void ProcamCalibrator::calibrateInternal(bool mirrored, const Size& projSize, co
 		virtualProj2Cam = Matx44d(virtualProj2CamMat);
 
 		Matx44d realProj2Cam = mp.reflectPose(virtualProj2Cam);
-		cam2Proj = realProj2Cam.inv();
+		return realProj2Cam.inv();
 	}
 	else
 	{
-		cam2Proj = projCalib.inv();
+		return projCalib.inv();
 	}
+}
 
-	std::cout << std::endl << "Stereo\n----------------\nRMS: " << stereoRMS << std::endl << "Cam2Proj:" << std::endl << cam2Proj << std::endl;
+ProcamCalibrator::ProcamCalibrator(): detector{DetectorPool::global().acquireCharucoDetector()}, views{ { 3, 2, 2 } }, projRMS{0}, stereoRMS{0}, detections{0}, rejectionThreshold{3}, mirrored{false}, structuredLightStep{8}, packCaptures{false}, grayscale{false}, patternSettle{2, 1000, 0}, boardSettle{5}
+{
+}
+
+void ProcamCalibrator::setDetector(std::shared_ptr<CharucoDetector> detector)
+{
+	this->detector = detector;
 }
 
-ProcamCalibrator::ProcamCalibrator(): detections{0}
+void ProcamCalibrator::setPackCaptures(bool packCaptures)
 {
+	this->packCaptures = packCaptures;
 }
 
-void ProcamCalibrator::init(const std::string& imgsFolder, const std::string& mirrorCalibName, Projector* proj, const std::string& camCalibName)
+bool ProcamCalibrator::setCaptureFormat(const std::string& format, int compression)
+{
+	return archiver.setFormat(format, compression);
+}
+
+void ProcamCalibrator::setGrayscale(bool grayscale)
+{
+	this->grayscale = grayscale;
+}
+
+void ProcamCalibrator::setDebugOutput(const std::string& output)
+{
+	debugSink.open(output);
+}
+
+void ProcamCalibrator::setTracking(bool tracking)
+{
+	if (tracking)
+		tracker = std::make_unique<CharucoTracker>(detector);
+	else
+		tracker.reset();
+}
+
+void ProcamCalibrator::setOutputName(const std::string& outputName)
+{
+	this->outputName = outputName;
+}
+
+void ProcamCalibrator::setOutlierRejection(double rejectionThreshold)
+{
+	this->rejectionThreshold = rejectionThreshold;
+}
+
+void ProcamCalibrator::setMaxViews(int maxViews)
+{
+	reservoir.setCapacity(maxViews);
+}
+
+void ProcamCalibrator::setCorrespondenceFile(const std::string& fileName)
+{
+	correspondenceFile = fileName;
+}
+
+bool ProcamCalibrator::init(const std::string& imgsFolder, const std::string& mirrorCalibName, Projector* proj, const std::string& camCalibName)
 {
 	this->mirrorCalibName = mirrorCalibName;
-	mp = MirrorPlane(mirrorCalibName);
-	init(imgsFolder, proj, camCalibName);
+	if (!mp.fromFile(mirrorCalibName))
+		return false;
+	return init(imgsFolder, proj, camCalibName);
 }
 
-void ProcamCalibrator::init(const std::string& imgsFolder, Projector* proj, const std::string& camCalibName)
+bool ProcamCalibrator::init(const std::string& imgsFolder, Projector* proj, const std::string& camCalibName)
 {
 	this->imgsFolder = imgsFolder;
 	this->proj = proj;
 	circlesGridSize = proj->getPatternSize();
 	this->camCalibName = camCalibName;
-	Utils::readJSONFileToCameraCalibration(camCalibName, camCalib);
+	if (!Utils::readJSONFileToCameraCalibration(camCalibName, camCalib))
+		return false;
 	std::cout << camCalib;
 	init();
+	return true;
 }
 
 void ProcamCalibrator::init()
 {
 	//objp = detector.getObjectPoints();
 
-	for (int i = 0; i < detector.getBoardSize().height; i++)
+	for (int i = 0; i < detector->getBoardSize().height; i++)
 	{
-		for (int j = 0; j < detector.getBoardSize().width; j++)
+		for (int j = 0; j < detector->getBoardSize().width; j++)
 		{
 			objp.push_back(Point3f{ (float)j * 4.43f, (float)i * 4.43f, 0.0f });
+			objpPlanar.push_back(Point2f{ (float)j * 4.43f, (float)i * 4.43f });
 		}
 	}
 
-	SimpleBlobDetector::Params paramsFrame;
-	paramsFrame.blobColor = 255;
-	paramsFrame.filterByColor = true;
-	paramsFrame.filterByArea = true;
-	paramsFrame.minArea = 20;
-	paramsFrame.filterByConvexity = 0;
-	paramsFrame.filterByInertia = 0;
-	paramsFrame.filterByCircularity = 1;
-	paramsFrame.minDistBetweenBlobs = 5;
-
-	// This parameter really does a lot for RMS
-	//paramsFrame.minThreshold = 200;
-	paramsFrame.minCircularity = 0.5;
-
-	circlesDetector = SimpleBlobDetector::create(paramsFrame);
+	circlesDetector = DetectorPool::global().acquireBlobDetector();
 }
 
 void ProcamCalibrator::calibrate(bool debug)
@@ -218,8 +519,17 @@ void ProcamCalibrator::calibrate(bool debug)
 		mirrored = true;
 	}
 
+	// The detections of an earlier run are solved again without reading the images
+	if (loadCorrespondences() > 0)
+	{
+		calibrateInternal(mirrored, proj->getCurrentPattern().size(), frameSize);
+		return;
+	}
+
+	if (!correspondenceFile.empty())
+		correspondenceWriter.open(correspondenceFile, { 3, 2, 2 });
+
 	int imgId = -1;
-	Mat refImg;
 
 	auto images = Utils::loadImages(imgsFolder);
 	capPerPattern = images.size() / proj->getNrPatterns();
@@ -228,6 +538,41 @@ void ProcamCalibrator::calibrate(bool debug)
 	if (debug)
 		debugDelay = 0;
 
+	if (proj->isStructuredLight())
+	{
+		// Every board pose is a run of captures of all the patterns
+		size_t nrPatterns = proj->getNrPatterns();
+		for (size_t first = 0; first + nrPatterns <= images.size(); first += nrPatterns)
+		{
+			std::vector<Mat> frames;
+			for (size_t i = 0; i < nrPatterns; ++i)
+			{
+				frames.push_back(Utils::readImage(images[first + i], true));
+			}
+			if (frameSize.empty())
+				frameSize = frames[StructuredLightPattern::whiteFrame].size();
+
+			std::cout << "Loaded pose " << first / nrPatterns << std::endl;
+
+			bool detected = detectStructuredLight(first / nrPatterns, frames, mirrored, debugDelay);
+			if (detected)
+			{
+				++detections;
+			}
+		}
+
+		if (debug)
+			destroyAllWindows();
+
+		correspondenceWriter.close();
+
+		std::cout << "==== Number detections: " << detections << std::endl;
+
+		proj->setPattern(StructuredLightPattern::whiteFrame);
+		calibrateInternal(mirrored, proj->getCurrentPattern().size(), frameSize);
+		return;
+	}
+
 	for (const auto& entry : images)
 	{
 		++imgId;
@@ -239,13 +584,13 @@ void ProcamCalibrator::calibrate(bool debug)
 
 		Mat pattern = proj->getCurrentPattern();
 
-		Mat img = imread(entry);
+		Mat img = Utils::readImage(entry, grayscale);
 		if (imgId == 0)
-			refImg = img;
+			frameSize = img.size();
 
 		std::cout << "Loaded image " << imgId << std::endl;
 
-		bool detected = detectAll(pattern, img, mirrored, debugDelay);
+		bool detected = detectAll(imgId, pattern, img, mirrored, debugDelay);
 		if (detected)
 		{
 			++detections;
@@ -253,33 +598,209 @@ void ProcamCalibrator::calibrate(bool debug)
 
 
 		//if(debug)
-			//calibrateInternal(mirrored, proj->getCurrentPattern().size(), refImg.size());
+			//calibrateInternal(mirrored, proj->getCurrentPattern().size(), frameSize);
 	}
 
-	destroyAllWindows();
+	if (debug)
+		destroyAllWindows();
+
+	correspondenceWriter.close();
 
 	std::cout << "==== Number detections: " << detections << std::endl;
 
-	calibrateInternal(mirrored, proj->getCurrentPattern().size(), refImg.size());
+	calibrateInternal(mirrored, proj->getCurrentPattern().size(), frameSize);
+}
+
+void ProcamCalibrator::saveCapture(int imgId, const Mat& img)
+{
+	archiver.submit(imgId, img);
+}
+
+Mat ProcamCalibrator::showPatternSettled(std::shared_ptr<DeviceFactory::Device> physCamera)
+{
+	// The projector still shows the previous pattern
+	Mat cap; double timestamp;
+	physCamera->captureImages(cap, timestamp);
+
+	// Once the display latency is known, a pattern that does not visibly change the frame only costs a short delay
+	if (!displayLatencies.empty())
+		patternSettle.setTimeout(std::max(minPatternTimeoutMs, (int)(2 * getDisplayLatency())));
+	patternSettle.reset(cap);
+
+	proj->showCurrentPattern();
+	do
+	{
+		physCamera->captureImages(cap, timestamp);
+		if (waitKey(1) == 'q')
+		{
+			destroyAllWindows();
+			exit(1);
+		}
+	} while (!patternSettle.update(cap));
+
+	if (!patternSettle.hasTimedOut())
+		displayLatencies.push_back(patternSettle.getSettleLatency());
+
+	return cap.clone();
+}
+
+double ProcamCalibrator::getDisplayLatency() const
+{
+	if (displayLatencies.empty())
+		return 0;
+
+	double sum = 0;
+	for (double latency : displayLatencies)
+		sum += latency;
+	return sum / displayLatencies.size();
+}
+
+void ProcamCalibrator::calibrateStructuredLight(std::shared_ptr<DeviceFactory::Device> physCamera, int poses)
+{
+	bool mirrored = false;
+	if (imgsFolder[0] == 'S')
+		mirrored = true;
+
+	// An interrupted session continues after the poses it already has
+	int pose = loadCorrespondences();
+	int imgId = pose * proj->getNrPatterns();
+	if (!correspondenceFile.empty())
+		correspondenceWriter.open(correspondenceFile, { 3, 2, 2 }, true);
+
+	if (!archiver.open(imgsFolder, packCaptures, imgId > 0))
+	{
+		std::cerr << "[ProcamCalibrator] Error: Could not open " << imgsFolder << " for the captures" << std::endl;
+		exit(1);
+	}
+
+	bool waitForBoard = false;
+	while (pose < poses)
+	{
+		// The board is positioned under white light
+		proj->setPattern(StructuredLightPattern::whiteFrame);
+		proj->showCurrentPattern();
+
+		Mat cap; double timestamp;
+		physCamera->captureImages(cap, timestamp);
+
+		const Mat& img = cap;
+		if (frameSize.empty())
+			frameSize = img.size();
+
+		imshow("Camera", img);
+		auto c = waitKey(1);
+		if (c == 'q')
+		{
+			destroyAllWindows();
+			exit(1);
+		}
+
+		// The next pose is only taken once the board was moved and holds still again
+		if (waitForBoard && c != 's' && !boardSettle.update(img))
+			continue;
+		waitForBoard = false;
+
+		size_t nrCorners;
+		if (tracker)
+		{
+			nrCorners = tracker->track(img, mirrored);
+		}
+		else
+		{
+			preprocessor.process(img, mirrored);
+			std::vector<Point2f> corners;
+			std::vector<int> ids;
+			detector->detectCharucoCorners(preprocessor.getGray(), corners, ids);
+			nrCorners = corners.size();
+		}
+
+		if (nrCorners < 35 && c != 's')
+			continue;
+
+		std::cout << "Capturing pose " << pose << "..\n";
+
+		// The white frame is already shown and still, every other pattern is captured once it is stably visible
+		std::vector<Mat> frames{ img.clone() };
+		for (int i = StructuredLightPattern::whiteFrame + 1; i < proj->getNrPatterns(); ++i)
+		{
+			proj->setPattern(i);
+			frames.push_back(showPatternSettled(physCamera));
+		}
+
+		bool detected = detectStructuredLight(pose, frames, mirrored, 1);
+		if (detected)
+		{
+			if (tracker)
+				tracker->reset();
+
+			// Back to white first, so the switch itself does not count as a moved board
+			proj->setPattern(StructuredLightPattern::whiteFrame);
+			boardSettle.reset(showPatternSettled(physCamera));
+			waitForBoard = true;
+
+			for (const auto& frame : frames)
+			{
+				saveCapture(imgId, frame);
+				++imgId;
+			}
+			++pose;
+			++detections;
+		}
+	}
+
+	archiver.close();
+	correspondenceWriter.close();
+	destroyAllWindows();
+
+	if (!displayLatencies.empty())
+		std::cout << "[ProcamCalibrator] Mean display to capture latency: " << getDisplayLatency() << " ms over " << displayLatencies.size() << " pattern switches" << std::endl;
+
+	proj->setPattern(StructuredLightPattern::whiteFrame);
+	calibrateInternal(mirrored, proj->getCurrentPattern().size(), frameSize);
 }
 
 void ProcamCalibrator::calibrate(std::shared_ptr<DeviceFactory::Device> physCamera, int capPerPattern)
 {
+	if (proj->isStructuredLight())
+	{
+		calibrateStructuredLight(physCamera, capPerPattern);
+		return;
+	}
+
 	bool mirrored = false;
 	if (imgsFolder[0] == 'S')
 		mirrored = true;
 
-	int imgId = 0;
-	Mat refImg;
+	// An interrupted session continues after the captures it already has, with the pattern it was at
+	int imgId = loadCorrespondences();
 	bool patternChanged = false;
+	if (imgId > 0 && imgId < capPerPattern * proj->getNrPatterns())
+	{
+		proj->setPattern(imgId / capPerPattern);
+		showPatternSettled(physCamera);
+		patternChanged = true;
+	}
+
+	if (!correspondenceFile.empty())
+		correspondenceWriter.open(correspondenceFile, { 3, 2, 2 }, true);
 
+	if (!archiver.open(imgsFolder, packCaptures, imgId > 0))
+	{
+		std::cerr << "[ProcamCalibrator] Error: Could not open " << imgsFolder << " for the captures" << std::endl;
+		exit(1);
+	}
+
+	bool waitForBoard = false;
 	while (imgId < capPerPattern * proj->getNrPatterns())
 	{
 		if (imgId % capPerPattern == 0 && !patternChanged)
 		{
 			proj->nextPattern();
-			proj->showCurrentPattern(false);
+			showPatternSettled(physCamera);
 			patternChanged = true;
+
+			// A new pattern is a new view, also when the board did not move
+			waitForBoard = false;
 		}
 
 		Mat pattern = proj->getCurrentPattern();
@@ -287,11 +808,11 @@ void ProcamCalibrator::calibrate(std::shared_ptr<DeviceFactory::Device> physCame
 		Mat cap; double timestamp;
 		physCamera->captureImages(cap, timestamp);
 
-		Mat img = cap.clone();
-		Mat sImg = cap.clone();
+		// Preview frames are only read, detectAll draws on a copy
+		const Mat& img = cap;
 
-		if (imgId == 0)
-			refImg = img;
+		if (frameSize.empty())
+			frameSize = img.size();
 
 		std::cout << "Trying new image..\n";
 
@@ -303,27 +824,221 @@ void ProcamCalibrator::calibrate(std::shared_ptr<DeviceFactory::Device> physCame
 			exit(1);
 		}
 
-		bool detected = detectAll(pattern, img, mirrored, 2000);
+		// The next capture is only taken once the board was moved and holds still again
+		if (waitForBoard && c != 's' && !boardSettle.update(img))
+			continue;
+		waitForBoard = false;
+
+		if (tracker && c != 's' && tracker->track(img, mirrored) < 35)
+			continue;
+
+		bool detected = detectAll(imgId, pattern, img.clone(), mirrored, 1);
 		if (detected || c == 's')
 		{
-			std::stringstream ss;
-			ss << std::setfill('0') << std::setw(2) << imgId << ".png";
-			Utils::verifyDirectories(imgsFolder + "/" + ss.str());
-			imwrite(imgsFolder + "/" + ss.str(), sImg);
+			// A forced capture keeps its id in the correspondence file, so a resumed session does not reuse it
+			if (!detected && correspondenceWriter.isOpened())
+				correspondenceWriter.write(imgId, img.size(), { Mat(0, 1, CV_32FC3), Mat(0, 1, CV_32FC2), Mat(0, 1, CV_32FC2) });
+
+			if (tracker)
+				tracker->reset();
+			boardSettle.reset(img);
+			waitForBoard = true;
+
+			saveCapture(imgId, img);
 			++imgId;
 			patternChanged = false;
 		}
 	}
 
+	archiver.close();
+	correspondenceWriter.close();
 	destroyAllWindows();
 
-	calibrateInternal(mirrored, proj->getCurrentPattern().size(), refImg.size());
+	if (!displayLatencies.empty())
+		std::cout << "[ProcamCalibrator] Mean display to capture latency: " << getDisplayLatency() << " ms over " << displayLatencies.size() << " pattern switches" << std::endl;
+
+	calibrateInternal(mirrored, proj->getCurrentPattern().size(), frameSize);
 }
 
+void ProcamCalibrator::calibrate(VideoFrameSource& video, const PatternSchedule& schedule, bool debug)
+{
+	bool mirrored = false;
+	if (mirrorCalibName != "")
+	{
+		mirrored = true;
+	}
+
+	int debugDelay = -1;
+	if (debug)
+		debugDelay = 0;
+
+	if (loadCorrespondences() > 0)
+	{
+		calibrateInternal(mirrored, proj->getCurrentPattern().size(), frameSize);
+		return;
+	}
+
+	if (!correspondenceFile.empty())
+		correspondenceWriter.open(correspondenceFile, { 3, 2, 2 });
+
+	int frameId = -1;
+	Size camSize;
+	Mat img;
+
+	while (video.next(img))
+	{
+		++frameId;
+
+		// Frames outside of the schedule are captured while the projector switches patterns
+		int patternId = schedule.patternAt(video.getFrameTime());
+		if (patternId < 0)
+			continue;
+
+		if (patternId != proj->getCurrentPatternId())
+		{
+			proj->setPattern(patternId);
+		}
+
+		Mat pattern = proj->getCurrentPattern();
 
-void ProcamCalibrator::saveToJSON()
+		if (camSize.empty())
+			camSize = img.size();
+
+		std::cout << "Loaded frame " << frameId << " at " << video.getFrameTime() << "s (pattern " << patternId << ")" << std::endl;
+
+		bool detected = detectAll(frameId, pattern, img, mirrored, debugDelay);
+		if (detected)
+		{
+			++detections;
+		}
+	}
+
+	destroyAllWindows();
+	correspondenceWriter.close();
+
+	std::cout << "==== Number detections: " << detections << std::endl;
+
+	if (detections == 0)
+	{
+		std::cerr << "[ProcamCalibrator] No detections in video, aborting.." << std::endl;
+		exit(1);
+	}
+
+	calibrateInternal(mirrored, proj->getCurrentPattern().size(), camSize);
+}
+
+bool ProcamCalibrator::addFrame(int patternId, const Mat& img)
+{
+	if (patternId != proj->getCurrentPatternId())
+	{
+		proj->setPattern(patternId);
+	}
+
+	if (frameSize.empty())
+		frameSize = img.size();
+
+	bool detected = detectAll(detections, proj->getCurrentPattern(), img, !mirrorCalibName.empty());
+	if (detected)
+	{
+		++detections;
+	}
+
+	return detected;
+}
+
+bool ProcamCalibrator::solve()
+{
+	if (detections == 0)
+	{
+		std::cerr << "[ProcamCalibrator] No detections to calibrate with" << std::endl;
+		return false;
+	}
+
+	try
+	{
+		calibrateInternal(!mirrorCalibName.empty(), proj->getCurrentPattern().size(), frameSize);
+	}
+	catch (const cv::Exception& e)
+	{
+		std::cerr << "[ProcamCalibrator] Error: Calibration failed: " << e.what() << std::endl;
+		return false;
+	}
+	return true;
+}
+
+int ProcamCalibrator::getDetections() const
+{
+	return detections;
+}
+
+float ProcamCalibrator::getProjectorRMS() const
+{
+	return projRMS;
+}
+
+float ProcamCalibrator::getStereoRMS() const
+{
+	return stereoRMS;
+}
+
+void ProcamCalibrator::estimateUncertainty(Uncertainty::Method method, int resamples)
+{
+	// Resamples of the views the solution was computed from
+	std::vector<double> stds = Uncertainty::estimate(method, keptViews.size(), resamples, [&](const std::vector<int>& sample)
+	{
+		std::vector<int> sampleViews;
+		for (int i : sample)
+			sampleViews.push_back(keptViews[i]);
+		std::vector<Mat> sampleObjPoints = views.getSet(0, sampleViews);
+		std::vector<Mat> sampleProjPoints = views.getSet(1, sampleViews);
+		std::vector<Mat> sampleCamPoints = views.getSet(2, sampleViews);
+
+		// Warm started from the solution of all views
+		Matx33d sampleInt = projInt;
+		std::vector<double> sampleDist = projDist;
+		Mat _rvecs, _tvecs;
+		calibrateCamera(sampleObjPoints, sampleProjPoints, projSize, sampleInt, sampleDist, _rvecs, _tvecs, CALIB_USE_INTRINSIC_GUESS);
+
+		Matx33d R = stereoR;
+		Matx31d T = stereoT;
+		Mat E, F;
+		stereoCalibrate(sampleObjPoints, sampleProjPoints, sampleCamPoints, sampleInt, sampleDist, camCalib.getIntrinsicsMatrix(), camCalib.getDistortionParameters(), frameSize, R, T, E, F, CALIB_FIX_INTRINSIC | CALIB_USE_EXTRINSIC_GUESS, TermCriteria(TermCriteria::COUNT + TermCriteria::EPS, 1e2, DBL_EPSILON));
+
+		Matx44d sampleVirtualProj2Cam;
+		Matx44d sampleCam2Proj = toCam2Proj(R, T, mirrored, sampleVirtualProj2Cam);
+		Matx31d rvec;
+		Rodrigues(sampleCam2Proj.get_minor<3, 3>(0, 0), rvec);
+
+		std::vector<double> params{ sampleInt(0, 0), sampleInt(1, 1), sampleInt(0, 2), sampleInt(1, 2) };
+		params.insert(params.end(), sampleDist.begin(), sampleDist.end());
+		params.insert(params.end(), { rvec(0), rvec(1), rvec(2), sampleCam2Proj(0, 3), sampleCam2Proj(1, 3), sampleCam2Proj(2, 3) });
+		return params;
+	});
+
+	if (stds.empty())
+	{
+		std::cerr << "[ProcamCalibrator] Not enough views to estimate the uncertainty" << std::endl;
+		return;
+	}
+
+	projIntStd = Matx33d::zeros();
+	projIntStd(0, 0) = stds[0];
+	projIntStd(1, 1) = stds[1];
+	projIntStd(0, 2) = stds[2];
+	projIntStd(1, 2) = stds[3];
+	projDistStd.assign(stds.begin() + 4, stds.end() - 6);
+	cam2ProjRvecStd.assign(stds.end() - 6, stds.end() - 3);
+	cam2ProjTvecStd.assign(stds.end() - 3, stds.end());
+
+	std::cout << "Projector intrinsics std:" << std::endl << projIntStd << std::endl;
+	std::cout << "Cam2Proj rotation std (rad): " << Mat(cam2ProjRvecStd).t() << std::endl << "Cam2Proj translation std: " << Mat(cam2ProjTvecStd).t() << std::endl;
+}
+
+bool ProcamCalibrator::saveToJSON()
 {
 	std::string seqName = std::filesystem::path(imgsFolder).filename().string();
+	if (!outputName.empty())
+		seqName = outputName;
 	const std::string filePath = Config::procamCalibrationFolder + "/" + seqName + ".json";
 	Utils::verifyDirectories(filePath);
 
@@ -331,7 +1046,7 @@ void ProcamCalibrator::saveToJSON()
 	if (!fs.isOpened())
 	{
 		std::cerr << "[ProcamCalibrator] Error: Could not open the input file " << filePath << std::endl;
-		exit(1);
+		return false;
 	}
 
 	fs << "cam_int" << camCalib.getIntrinsicsMatrix();
@@ -347,14 +1062,38 @@ void ProcamCalibrator::saveToJSON()
 	fs << "cam2proj" << cam2Proj;
 	fs << "stereo_RMS" << stereoRMS;
 	fs << "detections" << detections;
+	if (!displayLatencies.empty())
+		fs << "display_latency_ms" << getDisplayLatency();
+	if (!viewErrors.empty())
+	{
+		std::vector<int> keptIds;
+		for (int v : keptViews)
+			keptIds.push_back(viewIds[v]);
+		fs << "view_ids" << keptIds;
+		fs << "per_view_errors" << viewErrors;
+	}
+	if (!rejectedViews.empty())
+	{
+		fs << "rejected_views" << rejectedViews;
+		fs << "rejected_view_errors" << rejectedErrors;
+	}
 
-	if (imgsFolder[0] == 'S')
+	if (!projDistStd.empty())
+	{
+		fs << "proj_int_std" << projIntStd;
+		fs << "proj_dist_std" << projDistStd;
+		fs << "cam2proj_rvec_std" << cam2ProjRvecStd;
+		fs << "cam2proj_tvec_std" << cam2ProjTvecStd;
+	}
+
+	if (!mirrorCalibName.empty())
 	{
 		fs << "plane" << mp.getPlaneParams();
 		fs << "virtualProj2Cam" << virtualProj2Cam;
 	}
 
 	fs.release();
+	return true;
 }
 
 
@@ -1,7 +1,19 @@
 #pragma once
 #include "CharucoDetector.h"
+#include "DetectorPool.h"
 #include "MirrorPlane.h"
 #include "Projector.h"
+#include "PatternSchedule.h"
+#include "VideoFrameSource.h"
+#include "FrameArchiver.h"
+#include "DebugSink.h"
+#include "CharucoTracker.h"
+#include "CorrespondenceStore.h"
+#include "Uncertainty.h"
+#include "ViewReservoir.h"
+#include "CorrespondenceArena.h"
+#include "FramePreprocessor.h"
+#include "SettleDetector.h"
 #include "DeviceFactory/CameraCalibration.h"
 #include <opencv2/opencv.hpp>
 #include "Config.h"
@@ -13,17 +25,23 @@ private:
 	std::string imgsFolder;
 	std::string mirrorCalibName;
 	std::string camCalibName;
+	std::string outputName;
 
-	CharucoDetector detector;
+	std::shared_ptr<CharucoDetector> detector;
 	MirrorPlane mp;
 	Projector* proj;
 	CameraCalibration camCalib;
 
 	cv::Ptr<cv::FeatureDetector> circlesDetector;
+	FramePreprocessor preprocessor;
 	
-	std::vector <std::vector<cv::Point2f>> imgPointsVirtualProj;
-	std::vector<std::vector<cv::Point2f>> imgPointsCamera;
-	std::vector<std::vector<cv::Point3f>> objPointsVirtual;
+	// Virtual board, projector and camera points of every view
+	CorrespondenceArena views;
+
+	// Picks the views that are kept when their number is capped
+	ViewReservoir reservoir;
+	// Capture (or pose) id of every view in the arena
+	std::vector<int> viewIds;
 
 	cv::Matx33d projInt;
 	std::vector<double> projDist;
@@ -33,28 +51,114 @@ private:
 	float stereoRMS;
 	int detections;
 
+	// Views with a stereo error above median + rejectionThreshold * MAD are left out, 0 keeps every view
+	double rejectionThreshold;
+	// Capture ids and largest stereo errors of the rejected views, errors (projector, camera) of the views that are kept
+	std::vector<int> rejectedViews;
+	std::vector<double> rejectedErrors;
+	cv::Mat viewErrors;
+	// Arena indices of the views the last solve kept
+	std::vector<int> keptViews;
+	static const int maxRejectionRounds = 5;
+
+	// Solution of calibrateInternal, the starting point of the resamples
+	cv::Matx33d stereoR;
+	cv::Matx31d stereoT;
+	cv::Size projSize;
+	bool mirrored;
+
+	// Only filled by estimateUncertainty
+	cv::Matx33d projIntStd;
+	std::vector<double> projDistStd;
+	std::vector<double> cam2ProjRvecStd;
+	std::vector<double> cam2ProjTvecStd;
+
 	std::vector<cv::Point3f> objp;
+	std::vector<cv::Point2f> objpPlanar;
+	std::vector<cv::Point2f> undistortedPoints;
+	cv::Size frameSize;
 
 	int capPerPattern;
 	cv::Size circlesGridSize;
 
-	std::vector<cv::Point3f> pointsToBoardSpace(std::vector<cv::Point2f> points2d, std::vector<cv::Point2f> refPoints2d, std::vector<cv::Point3f> objp, cv::Matx33d cameraIntrinsics, std::vector<double> distortionCoeffs);
+	// Spacing in camera pixels of the decoded structured light points that are used
+	int structuredLightStep;
+
+	bool packCaptures;
+	FrameArchiver archiver;
+
+	bool grayscale;
+
+	DebugSink debugSink;
+
+	// Only set in tracking mode
+	std::unique_ptr<CharucoTracker> tracker;
 
-	bool detectAll(cv::Mat pattern, cv::Mat img, bool mirrored, int debugDelay = -1);
+	// Board, projector and camera points of every detection
+	std::string correspondenceFile;
+	CorrespondenceWriter correspondenceWriter;
+
+	// Live captures wait until a new pattern is stably visible, and after a capture until the board was moved and held still.
+	// Patterns are compared at full resolution, the timeout drops to twice the display latency once it is measured.
+	SettleDetector patternSettle;
+	SettleDetector boardSettle;
+	std::vector<double> displayLatencies;
+	static const int minPatternTimeoutMs = 100;
+
+	std::vector<cv::Point3f> pointsToBoardSpace(const std::vector<cv::Point2f>& points2d, const std::vector<cv::Point2f>& refPoints2d, const cv::Matx33d& cameraIntrinsics, const std::vector<double>& distortionCoeffs);
+
+	// The id of the capture, or of the pose for structured light, is saved with the correspondences of a detection
+	bool detectAll(int id, cv::Mat pattern, cv::Mat img, bool mirrored, int debugDelay = -1);
+	bool detectStructuredLight(int pose, const std::vector<cv::Mat>& frames, bool mirrored, int debugDelay = -1);
+	void calibrateStructuredLight(std::shared_ptr<DeviceFactory::Device> physCamera, int poses);
+	cv::Mat showPatternSettled(std::shared_ptr<DeviceFactory::Device> physCamera);
+	double getDisplayLatency() const;
+	void saveCapture(int imgId, const cv::Mat& img);
+	// Returns the capture (or pose) id after the last stored view, 0 without stored views
+	int loadCorrespondences();
+	void addView(int id, const cv::Mat& boardPoints, const cv::Mat& patternPoints, const cv::Mat& framePoints, const cv::Size& frameSize);
 	void calibrateInternal(bool mirrored, const cv::Size& projSize, const cv::Size& camSize);
+	std::vector<int> findOutlierViews(const cv::Mat& perViewErrors) const;
+	cv::Matx44d toCam2Proj(const cv::Matx33d& R, const cv::Matx31d& T, bool mirrored, cv::Matx44d& virtualProj2Cam);
 
 	void init();
 
 public:
 	ProcamCalibrator();
 
-	void init(const std::string& imgsFolder, const std::string& mirrorCalibName, Projector* proj, const std::string& camCalibName = "camGT");
-	void init(const std::string& imgsFolder, Projector* proj, const std::string& camCalibName = "camGT");
+	void setDetector(std::shared_ptr<CharucoDetector> detector);
+	bool init(const std::string& imgsFolder, const std::string& mirrorCalibName, Projector* proj, const std::string& camCalibName = "camGT");
+	bool init(const std::string& imgsFolder, Projector* proj, const std::string& camCalibName = "camGT");
 
 	void setCapturesPerPattern(int capPerPattern);
+	void setPackCaptures(bool packCaptures);
+	// Image format and PNG compression level of the live captures, see FrameArchiver::setFormat
+	bool setCaptureFormat(const std::string& format, int compression);
+	void setGrayscale(bool grayscale);
+	void setDebugOutput(const std::string& output);
+	void setTracking(bool tracking);
+	void setOutputName(const std::string& outputName);
+	void setOutlierRejection(double rejectionThreshold);
+	// At most maxViews views are kept in memory and solved, balanced over the camera image. 0 keeps every view.
+	void setMaxViews(int maxViews);
+
+	// Detections are saved to the file, and read from it instead of detected again when it exists
+	void setCorrespondenceFile(const std::string& fileName);
 
 	void calibrate(bool debug = false);
 	void calibrate(std::shared_ptr<DeviceFactory::Device> physCamera, int capPerPattern);
-	void saveToJSON();
+	void calibrate(VideoFrameSource& video, const PatternSchedule& schedule, bool debug = false);
+
+	// Frame by frame calibration for frames that are not read from a recording
+	bool addFrame(int patternId, const cv::Mat& img);
+	bool solve();
+	int getDetections() const;
+	float getProjectorRMS() const;
+	float getStereoRMS() const;
+
+	// Standard deviations of the projector intrinsics and cam2Proj from resamples of the views, call after calibrate
+	void estimateUncertainty(Uncertainty::Method method, int resamples = 100);
+
+	bool saveToJSON();
 };
 
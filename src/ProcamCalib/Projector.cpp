@@ -3,6 +3,7 @@
 #include <iostream>
 #include <opencv2/highgui.hpp>
 #include <opencv2/core.hpp>
+#include <opencv2/calib3d.hpp>
 #include <map>
 #include "Config.h"
 #include "Utils.h"
@@ -21,10 +22,44 @@ Projector::Projector(std::string patternFolder): currentPatternId{-1}
 	circlesGridSize = Size(std::stoi(patternFolder.substr(widthidx + 1, heightidx - (widthidx + 1))), std::stoi(patternFolder.substr(heightidx + 1, patternFolder.size() - heightidx)));
 }
 
+Projector::Projector(std::shared_ptr<StructuredLightPattern> structuredLight): currentPatternId{-1}, structuredLight{structuredLight}
+{
+	generatedPatterns = structuredLight->generate();
+	std::cout << "Generated " << generatedPatterns.size() << " structured light patterns for " << structuredLight->getResolution().width << "x" << structuredLight->getResolution().height << std::endl;
+}
+
+Projector::Projector(const CirclesGridLayout& layout): currentPatternId{-1}, circlesGridSize{layout.gridSize}
+{
+	generator = std::make_shared<PatternGenerator>(layout);
+	for (int i = 0; i < generator->getNrPatterns(); ++i)
+	{
+		generatedPatterns.push_back(generator->render(i));
+	}
+	std::cout << "Generated " << generatedPatterns.size() << " circle grid patterns for " << layout.resolution.width << "x" << layout.resolution.height << std::endl;
+}
+
 void Projector::nextPattern()
 {
 	currentPatternId++;
-	currentPattern = imread(patternPaths[currentPatternId]);
+	if (!generatedPatterns.empty())
+		currentPattern = generatedPatterns[currentPatternId];
+	else
+		currentPattern = Utils::readImage(patternPaths[currentPatternId]);
+}
+
+void Projector::setPattern(int patternId)
+{
+	if (patternId < 0 || patternId >= getNrPatterns())
+	{
+		std::cerr << "[Projector] Pattern " << patternId << " does not exist, only " << getNrPatterns() << " patterns loaded" << std::endl;
+		exit(1);
+	}
+
+	currentPatternId = patternId;
+	if (!generatedPatterns.empty())
+		currentPattern = generatedPatterns[currentPatternId];
+	else
+		currentPattern = Utils::readImage(patternPaths[currentPatternId]);
 }
 
 void Projector::showCurrentPattern(bool shortDelay)
@@ -54,8 +89,15 @@ Mat Projector::getCurrentPattern()
 	return currentPattern;
 }
 
+int Projector::getCurrentPatternId()
+{
+	return currentPatternId;
+}
+
 int Projector::getNrPatterns()
 {
+	if (!generatedPatterns.empty())
+		return generatedPatterns.size();
 	return patternPaths.size();
 }
 
@@ -63,3 +105,45 @@ cv::Size Projector::getPatternSize()
 {
 	return circlesGridSize;
 }
+
+bool Projector::isStructuredLight() const
+{
+	return structuredLight != nullptr;
+}
+
+const StructuredLightPattern& Projector::getStructuredLight() const
+{
+	return *structuredLight;
+}
+
+const std::vector<Point2f>& Projector::findCurrentCircles(const Ptr<FeatureDetector>& blobDetector)
+{
+	auto it = circlesCache.find(currentPatternId);
+	if (it != circlesCache.end())
+		return it->second;
+
+	std::vector<Point2f> circles;
+	bool found = findCirclesGrid(currentPattern, circlesGridSize, circles, (CALIB_CB_ASYMMETRIC_GRID + CALIB_CB_CLUSTERING), blobDetector);
+	if (!found || (int)circles.size() != circlesGridSize.area())
+	{
+		std::cerr << "[Projector] Error: Could not find the circle grid in pattern " << currentPatternId << std::endl;
+		circles.clear();
+	}
+	else if (generator)
+	{
+		// Keep the order of the detection, which matches the detection in the camera, with the rendered centres
+		std::vector<Point2f> centers = generator->getCenters(currentPatternId);
+		for (auto& c : circles)
+		{
+			Point2f nearest = centers.front();
+			for (const auto& center : centers)
+			{
+				if (norm(center - c) < norm(nearest - c))
+					nearest = center;
+			}
+			c = nearest;
+		}
+	}
+
+	return circlesCache[currentPatternId] = circles;
+}
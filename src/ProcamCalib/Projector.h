@@ -1,7 +1,12 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <map>
+#include <memory>
 #include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include "StructuredLightPattern.h"
+#include "PatternGenerator.h"
 
 class Projector
 {
@@ -11,13 +16,31 @@ private:
 	cv::Mat currentPattern;
 	cv::Size circlesGridSize;
 
+	std::map<int, std::vector<cv::Point2f>> circlesCache;
+
+	// Only set for structured light or generated circle grids, the patterns are rendered once instead of loaded
+	std::shared_ptr<StructuredLightPattern> structuredLight;
+	std::shared_ptr<PatternGenerator> generator;
+	std::vector<cv::Mat> generatedPatterns;
+
 public:
 	Projector(std::string patternFolder);
+	Projector(std::shared_ptr<StructuredLightPattern> structuredLight);
+	Projector(const CirclesGridLayout& layout);
 
 	void nextPattern();
+	void setPattern(int patternId);
 	void showCurrentPattern(bool shortDelay = true);
 	cv::Mat getCurrentPattern();
+	int getCurrentPatternId();
 	int getNrPatterns();
 	cv::Size getPatternSize();
+
+	bool isStructuredLight() const;
+	const StructuredLightPattern& getStructuredLight() const;
+
+	// Circle grid of the current pattern, only detected the first time a pattern is used, empty when it is not found.
+	// The centres of generated patterns are known to 1/16 pixel, the detection only orders them.
+	const std::vector<cv::Point2f>& findCurrentCircles(const cv::Ptr<cv::FeatureDetector>& blobDetector);
 };
 
@@ -0,0 +1,21 @@
+#pragma once
+#include <vector>
+#include <opencv2/core.hpp>
+
+// Sequence of patterns that encodes the projector pixel of every camera pixel, projected for every board pose
+class StructuredLightPattern
+{
+public:
+	virtual ~StructuredLightPattern() = default;
+
+	// Index of the white frame, which is used to detect the board
+	static const int whiteFrame = 0;
+
+	virtual std::vector<cv::Mat> generate() const = 0;
+	virtual int getNrPatterns() const = 0;
+	virtual cv::Size getResolution() const = 0;
+
+	// frames are the grayscale captures of the generated patterns, in order. projCoords (CV_32FC2) holds the projector pixel
+	// seen by every camera pixel, valid is set where every frame had enough contrast.
+	virtual bool decode(const std::vector<cv::Mat>& frames, cv::Mat& projCoords, cv::Mat& valid, int contrastThreshold = 10) const = 0;
+};
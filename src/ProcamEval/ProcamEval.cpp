@@ -0,0 +1,59 @@
+#include <iostream>
+#include <string>
+#include "ProcamEvaluator.h"
+
+using namespace std;
+
+class CmdLineParser {
+
+private:
+    int argc; char** argv;
+
+public:
+    CmdLineParser(int _argc, char** _argv) :argc(_argc), argv(_argv) {}  bool operator[] (string param) { int idx = -1;  for (int i = 0; i < argc && idx == -1; i++) if (string(argv[i]) == param) idx = i;	return (idx != -1); } string operator()(string param, string defvalue = "") { int idx = -1;	for (int i = 0; i < argc && idx == -1; i++) if (string(argv[i]) == param) idx = i; if (idx == -1) return defvalue;   else  return (argv[idx + 1]); }
+};
+
+int main(int argc, char** argv)
+{
+    CmdLineParser cml(argc, argv);
+    if (argc < 3 || cml["-h"]) {
+        cerr << std::endl << "Usage: ./ProcamEval estimation groundtruth [-recording] [-square] [-threads] [-o report.json] [-maxerror]" << std::endl;
+        cerr << std::endl << "Compares a procam calibration to a ground truth and prints the differences of the poses and intrinsics, and the reprojection and ray reflection errors of the board corners in a recording." << std::endl;
+        cerr << std::endl << "estimation: procam calibration saved by ProcamCalib. groundtruth: file with the same keys, e.g. data/gt/S0_0.json. Both have a plane for a mirrored setup." << std::endl;
+        cerr << std::endl << "[-recording]: folder with frames of the charuco board, e.g. the recording the calibration was made with. Without it only the poses and intrinsics are compared." << std::endl;
+        cerr << std::endl << "[-square]: side of a board square, in the unit of the calibrations. Defaults to 4.43." << std::endl;
+        cerr << std::endl << "[-threads]: number of frames evaluated at the same time, defaults to the number of cores." << std::endl;
+        cerr << std::endl << "[-o]: also write the report to this JSON file." << std::endl;
+        cerr << std::endl << "[-maxerror]: exit with an error when the mean reprojection error is larger than this many projector pixels." << std::endl;
+        return 0;
+    }
+
+    ProcamEvaluator evaluator;
+    if (!evaluator.init(argv[1], argv[2]))
+        exit(1);
+    evaluator.setSquareLength(std::stof(cml("-square", "4.43")));
+
+    EvaluationReport report = evaluator.evaluate(cml("-recording"), std::stoi(cml("-threads", "0")));
+
+    std::cout << std::endl << "[ProcamEval] " << argv[1] << std::endl;
+    report.print(std::cout);
+
+    if (cml["-o"])
+        report.saveToJSON(cml("-o"));
+
+    if (cml["-maxerror"])
+    {
+        if (report.reprojection.count == 0)
+        {
+            cerr << "[ProcamEval] No board corners found to compare with [-maxerror]" << endl;
+            exit(1);
+        }
+        if (report.reprojection.mean > std::stod(cml("-maxerror")))
+        {
+            cerr << "[ProcamEval] Mean reprojection error " << report.reprojection.mean << " is larger than " << cml("-maxerror") << endl;
+            exit(1);
+        }
+    }
+
+    return 0;
+}
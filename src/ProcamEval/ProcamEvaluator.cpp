@@ -0,0 +1,337 @@
+#include "ProcamEvaluator.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include "DetectorPool.h"
+#include "ThreadPool.h"
+#include "Utils.h"
+
+using namespace cv;
+
+static bool readMatrix(const FileNode& node, int rows, int cols, Mat& m)
+{
+	if (node.empty())
+		return false;
+
+	// Ground truth files store the matrices as plain arrays, row by row
+	if (node.isSeq())
+	{
+		std::vector<double> values;
+		node >> values;
+		if ((int)values.size() != rows * cols)
+			return false;
+		m = Mat(values, true).reshape(1, rows);
+	}
+	else
+	{
+		node >> m;
+		m.convertTo(m, CV_64F);
+	}
+
+	return m.rows == rows && m.cols == cols;
+}
+
+bool ProcamModel::load(const std::string& fileName)
+{
+	FileStorage fs(fileName, FileStorage::READ + FileStorage::FORMAT_JSON);
+	if (!fs.isOpened())
+	{
+		std::cerr << "[ProcamEvaluator] Error: Could not open the input file " << fileName << std::endl;
+		return false;
+	}
+
+	Mat camIntMat, projIntMat, cam2ProjMat;
+	if (!readMatrix(fs["cam_int"], 3, 3, camIntMat) || !readMatrix(fs["proj_int"], 3, 3, projIntMat) || !readMatrix(fs["cam2proj"], 4, 4, cam2ProjMat))
+	{
+		std::cerr << "[ProcamEvaluator] " << fileName << " should have a cam_int, proj_int and cam2proj" << std::endl;
+		return false;
+	}
+	camInt = Matx33d(camIntMat);
+	projInt = Matx33d(projIntMat);
+	cam2Proj = Matx44d(cam2ProjMat);
+	fs["cam_dist"] >> camDist;
+	fs["proj_dist"] >> projDist;
+
+	std::vector<double> planeParams;
+	fs["plane"] >> planeParams;
+	mirrored = planeParams.size() == 4;
+	if (mirrored)
+	{
+		double norm = std::sqrt(planeParams[0] * planeParams[0] + planeParams[1] * planeParams[1] + planeParams[2] * planeParams[2]);
+		plane = Vec4d(planeParams[0], planeParams[1], planeParams[2], planeParams[3]) / norm;
+	}
+
+	return true;
+}
+
+Point3d ProcamModel::reflect(const Point3d& point) const
+{
+	Point3d normal{ plane[0], plane[1], plane[2] };
+	return point - 2 * (normal.dot(point) + plane[3]) * normal;
+}
+
+Point3d ProcamModel::toProjectorSpace(const Point3d& point) const
+{
+	Matx41d p = cam2Proj * Matx41d(point.x, point.y, point.z, 1);
+	return Point3d{ p(0), p(1), p(2) };
+}
+
+Point2d ProcamModel::toProjector(const Point3d& point) const
+{
+	std::vector<Point3d> points{ toProjectorSpace(point) };
+	std::vector<Point2d> pixels;
+	projectPoints(points, Vec3d::zeros(), Vec3d::zeros(), projInt, projDist, pixels);
+	return pixels[0];
+}
+
+ErrorStats ErrorStats::of(std::vector<double> errors)
+{
+	ErrorStats stats;
+	stats.count = errors.size();
+	if (errors.empty())
+		return stats;
+
+	std::sort(errors.begin(), errors.end());
+	for (double e : errors)
+		stats.mean += e;
+	stats.mean /= errors.size();
+	stats.median = errors[errors.size() / 2];
+	stats.max = errors.back();
+	return stats;
+}
+
+void EvaluationReport::print(std::ostream& os) const
+{
+	os << std::fixed << std::setprecision(4);
+	os << "| Metric | Error |" << std::endl;
+	os << "| --- | --- |" << std::endl;
+	os << "| cam2proj rotation (deg) | " << rotationError << " |" << std::endl;
+	os << "| cam2proj translation | " << translationError << " |" << std::endl;
+	os << "| projector fx, fy, cx, cy (px) | " << projIntError[0] << ", " << projIntError[1] << ", " << projIntError[2] << ", " << projIntError[3] << " |" << std::endl;
+	os << "| camera fx, fy, cx, cy (px) | " << camIntError[0] << ", " << camIntError[1] << ", " << camIntError[2] << ", " << camIntError[3] << " |" << std::endl;
+	os << "| mirror normal (deg) | " << planeAngleError << " |" << std::endl;
+	os << "| mirror offset | " << planeOffsetError << " |" << std::endl;
+
+	if (frames == 0)
+		return;
+
+	os << std::endl << "Corners of " << detections << " of " << frames << " frames" << std::endl << std::endl;
+	os << "| Projector pixels | Points | Mean | Median | Max |" << std::endl;
+	os << "| --- | --- | --- | --- | --- |" << std::endl;
+	os << "| reprojection | " << reprojection.count << " | " << reprojection.mean << " | " << reprojection.median << " | " << reprojection.max << " |" << std::endl;
+	os << "| ray reflection | " << rayReflection.count << " | " << rayReflection.mean << " | " << rayReflection.median << " | " << rayReflection.max << " |" << std::endl;
+}
+
+void EvaluationReport::saveToJSON(const std::string& fileName) const
+{
+	Utils::verifyDirectories(fileName);
+	FileStorage fs(fileName, FileStorage::WRITE + FileStorage::FORMAT_JSON);
+	if (!fs.isOpened())
+	{
+		std::cerr << "[ProcamEvaluator] Error: Could not open the output file " << fileName << std::endl;
+		exit(1);
+	}
+
+	fs << "rotation_error" << rotationError;
+	fs << "translation_error" << translationError;
+	fs << "proj_int_error" << projIntError;
+	fs << "cam_int_error" << camIntError;
+	fs << "plane_angle_error" << planeAngleError;
+	fs << "plane_offset_error" << planeOffsetError;
+	fs << "frames" << frames;
+	fs << "detections" << detections;
+
+	auto writeStats = [&](const std::string& name, const ErrorStats& stats)
+	{
+		fs << name << "{" << "count" << stats.count << "mean" << stats.mean << "median" << stats.median << "max" << stats.max << "}";
+	};
+	writeStats("reprojection", reprojection);
+	writeStats("ray_reflection", rayReflection);
+	fs.release();
+}
+
+ProcamEvaluator::ProcamEvaluator(): squareLength{4.43f}
+{
+}
+
+bool ProcamEvaluator::init(const std::string& estimateFile, const std::string& groundTruthFile)
+{
+	if (!estimate.load(estimateFile) || !groundTruth.load(groundTruthFile))
+		return false;
+
+	if (estimate.mirrored != groundTruth.mirrored)
+	{
+		std::cerr << "[ProcamEvaluator] Only one of the estimate and the ground truth has a mirror plane" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+void ProcamEvaluator::setSquareLength(float squareLength)
+{
+	this->squareLength = squareLength;
+}
+
+bool ProcamEvaluator::boardInCamera(const ProcamModel& model, const std::vector<Point2f>& corners, const std::vector<int>& ids, const Size& boardSize, std::vector<Point3d>& points) const
+{
+	// Through the mirror the camera sees a mirror image of the board, which is a rigid transform of the flipped board
+	std::vector<Point3f> objectPoints;
+	for (int id : ids)
+	{
+		float x = (id % boardSize.width) * squareLength;
+		float y = (id / boardSize.width) * squareLength;
+		objectPoints.push_back(Point3f{ model.mirrored ? -x : x, y, 0.0f });
+	}
+
+	Matx31d rvec, tvec;
+	if (!solvePnP(objectPoints, corners, model.camInt, model.camDist, rvec, tvec))
+		return false;
+
+	Matx33d R;
+	Rodrigues(rvec, R);
+	points.clear();
+	for (const auto& p : objectPoints)
+	{
+		Matx31d x = R * Matx31d(p.x, p.y, p.z) + tvec;
+		points.push_back(Point3d{ x(0), x(1), x(2) });
+	}
+	return true;
+}
+
+bool ProcamEvaluator::evaluateFrame(const std::string& entry, std::vector<double>& reprojection, std::vector<double>& rayReflection) const
+{
+	std::shared_ptr<CharucoDetector> detector = DetectorPool::global().acquireCharucoDetector();
+
+	// Frames of a packed recording are read only, flip into a new image
+	Mat gray = Utils::readImage(entry, true);
+	if (gray.empty())
+	{
+		std::cerr << "[ProcamEvaluator] Could not read " << entry << std::endl;
+		return false;
+	}
+	if (estimate.mirrored)
+	{
+		Mat flipped;
+		flip(gray, flipped, 1);
+		gray = flipped;
+	}
+
+	std::vector<Point2f> corners;
+	std::vector<int> ids;
+	detector->detectCharucoCorners(gray, corners, ids);
+	if (corners.size() < 6)
+		return false;
+
+	if (estimate.mirrored)
+		Utils::flip2dPoints(corners, gray.cols);
+
+	std::vector<Point3d> estPoints, gtPoints;
+	if (!boardInCamera(estimate, corners, ids, detector->getBoardSize(), estPoints) || !boardInCamera(groundTruth, corners, ids, detector->getBoardSize(), gtPoints))
+		return false;
+
+	// The ground truth projections in the ideal (undistorted) pixels of the estimated projector
+	std::vector<Point2d> gtPixels, gtIdealPixels;
+	for (size_t i = 0; i < corners.size(); ++i)
+	{
+		Point3d gtPoint = groundTruth.mirrored ? groundTruth.reflect(gtPoints[i]) : gtPoints[i];
+		gtPixels.push_back(groundTruth.toProjector(gtPoint));
+	}
+	undistortPoints(gtPixels, gtIdealPixels, estimate.projInt, estimate.projDist, noArray(), estimate.projInt);
+
+	auto pinhole = [&](const Point3d& p)
+	{
+		Point3d q = estimate.toProjectorSpace(p);
+		return Point2d{ estimate.projInt(0, 0) * q.x / q.z + estimate.projInt(0, 2), estimate.projInt(1, 1) * q.y / q.z + estimate.projInt(1, 2) };
+	};
+
+	// The ray leaves the camera, or its mirror image, through the corner
+	Point3d rayOrigin = estimate.mirrored ? estimate.reflect(Point3d{ 0, 0, 0 }) : Point3d{ 0, 0, 0 };
+	for (size_t i = 0; i < corners.size(); ++i)
+	{
+		Point3d estPoint = estimate.mirrored ? estimate.reflect(estPoints[i]) : estPoints[i];
+		reprojection.push_back(norm(estimate.toProjector(estPoint) - gtPixels[i]));
+
+		Point2d a = pinhole(rayOrigin);
+		Point2d b = pinhole(estPoint);
+		Point2d ab = b - a;
+		Point2d ap = gtIdealPixels[i] - a;
+		rayReflection.push_back(std::abs(ab.cross(ap)) / norm(ab));
+	}
+
+	return true;
+}
+
+EvaluationReport ProcamEvaluator::evaluate(const std::string& recording, int nrThreads)
+{
+	EvaluationReport report;
+
+	Matx33d R = estimate.cam2Proj.get_minor<3, 3>(0, 0) * groundTruth.cam2Proj.get_minor<3, 3>(0, 0).t();
+	report.rotationError = std::acos(std::min(1.0, std::max(-1.0, (trace(R) - 1) / 2))) * 180 / CV_PI;
+	report.translationError = norm(estimate.cam2Proj.get_minor<3, 1>(0, 3) - groundTruth.cam2Proj.get_minor<3, 1>(0, 3));
+
+	auto intrinsicsError = [](const Matx33d& est, const Matx33d& gt)
+	{
+		return Vec4d(est(0, 0) - gt(0, 0), est(1, 1) - gt(1, 1), est(0, 2) - gt(0, 2), est(1, 2) - gt(1, 2));
+	};
+	report.projIntError = intrinsicsError(estimate.projInt, groundTruth.projInt);
+	report.camIntError = intrinsicsError(estimate.camInt, groundTruth.camInt);
+
+	if (estimate.mirrored)
+	{
+		// The sign of a plane is arbitrary
+		Vec4d estPlane = estimate.plane;
+		Vec4d gtPlane = groundTruth.plane;
+		double cosAngle = estPlane[0] * gtPlane[0] + estPlane[1] * gtPlane[1] + estPlane[2] * gtPlane[2];
+		if (cosAngle < 0)
+		{
+			estPlane = -estPlane;
+			cosAngle = -cosAngle;
+		}
+		report.planeAngleError = std::acos(std::min(1.0, cosAngle)) * 180 / CV_PI;
+		report.planeOffsetError = estPlane[3] - gtPlane[3];
+	}
+
+	if (recording.empty())
+		return report;
+
+	std::vector<std::string> entries = Utils::loadImages(recording);
+	std::vector<std::vector<double>> reprojection(entries.size()), rayReflection(entries.size());
+	std::vector<char> detected(entries.size(), 0);
+	{
+		ThreadPool pool(nrThreads);
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			pool.submit([&, i](int)
+			{
+				try
+				{
+					detected[i] = evaluateFrame(entries[i], reprojection[i], rayReflection[i]);
+				}
+				catch (const std::exception& e)
+				{
+					std::cerr << "[ProcamEvaluator] Frame " << entries[i] << " failed: " << e.what() << std::endl;
+					reprojection[i].clear();
+					rayReflection[i].clear();
+				}
+			});
+		}
+		pool.wait();
+	}
+
+	std::vector<double> allReprojection, allRayReflection;
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		allReprojection.insert(allReprojection.end(), reprojection[i].begin(), reprojection[i].end());
+		allRayReflection.insert(allRayReflection.end(), rayReflection[i].begin(), rayReflection[i].end());
+	}
+
+	report.frames = entries.size();
+	report.detections = std::count(detected.begin(), detected.end(), 1);
+	report.reprojection = ErrorStats::of(allReprojection);
+	report.rayReflection = ErrorStats::of(allRayReflection);
+	return report;
+}
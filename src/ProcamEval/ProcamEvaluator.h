@@ -0,0 +1,80 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+// Camera, projector and mirror of a procam calibration, read from the output of ProcamCalib or from a ground truth
+// file with the same keys, where the matrices can also be plain arrays
+struct ProcamModel
+{
+	cv::Matx33d camInt;
+	std::vector<double> camDist;
+	cv::Matx33d projInt;
+	std::vector<double> projDist;
+	cv::Matx44d cam2Proj;
+
+	// Plane with a unit normal, the camera sees the scene through the mirror when set
+	bool mirrored = false;
+	cv::Vec4d plane;
+
+	bool load(const std::string& fileName);
+
+	cv::Point3d reflect(const cv::Point3d& point) const;
+	cv::Point3d toProjectorSpace(const cv::Point3d& point) const;
+	cv::Point2d toProjector(const cv::Point3d& point) const;
+};
+
+struct ErrorStats
+{
+	int count = 0;
+	double mean = 0;
+	double median = 0;
+	double max = 0;
+
+	static ErrorStats of(std::vector<double> errors);
+};
+
+struct EvaluationReport
+{
+	// Estimate minus ground truth
+	double rotationError = 0;		// degrees between the cam2proj rotations
+	double translationError = 0;	// distance between the cam2proj translations
+	cv::Vec4d projIntError;			// fx, fy, cx, cy
+	cv::Vec4d camIntError;
+	double planeAngleError = 0;		// degrees between the mirror normals
+	double planeOffsetError = 0;
+
+	int frames = 0;
+	int detections = 0;
+
+	// Projector pixels between where the estimate and the ground truth project an observed board corner
+	ErrorStats reprojection;
+	// Projector pixels between the ground truth projection of a board corner and the line the estimated camera ray
+	// through it projects to, independent of the estimated depth of the board
+	ErrorStats rayReflection;
+
+	void print(std::ostream& os) const;
+	void saveToJSON(const std::string& fileName) const;
+};
+
+// Compares a procam calibration to a ground truth. The pose differences only need the two files, the reprojection
+// and ray reflection errors use the charuco corners of every frame of a recording, detected on all cores.
+class ProcamEvaluator
+{
+private:
+	ProcamModel estimate;
+	ProcamModel groundTruth;
+	float squareLength;
+
+	bool evaluateFrame(const std::string& entry, std::vector<double>& reprojection, std::vector<double>& rayReflection) const;
+	bool boardInCamera(const ProcamModel& model, const std::vector<cv::Point2f>& corners, const std::vector<int>& ids, const cv::Size& boardSize, std::vector<cv::Point3d>& points) const;
+
+public:
+	ProcamEvaluator();
+
+	bool init(const std::string& estimateFile, const std::string& groundTruthFile);
+	void setSquareLength(float squareLength);
+
+	EvaluationReport evaluate(const std::string& recording = "", int nrThreads = 0);
+};
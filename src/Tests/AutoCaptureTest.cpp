@@ -0,0 +1,118 @@
+#include <cmath>
+#include <opencv2/core.hpp>
+#include "AutoCapture.h"
+#include "TestUtils.h"
+
+using namespace cv;
+
+// 800x600 frames have a diagonal of 1000 pixels, novelty is then the mean corner distance / 1000
+static const Size frameSize(800, 600);
+
+// 4x4 corner grid with ids first..first+15, offset by (dx, dy)
+static void board(float dx, float dy, std::vector<Point2f>& corners, std::vector<int>& ids, int first = 0)
+{
+	corners.clear();
+	ids.clear();
+	for (int y = 0; y < 4; ++y)
+	{
+		for (int x = 0; x < 4; ++x)
+		{
+			corners.push_back(Point2f(100 + 20 * x + dx, 100 + 20 * y + dy));
+			ids.push_back(first + y * 4 + x);
+		}
+	}
+}
+
+static void testStill()
+{
+	AutoCapture capture(0.05, 3, 0.5);
+	std::vector<Point2f> corners;
+	std::vector<int> ids;
+	board(0, 0, corners, ids);
+
+	// The first frame has no previous one, the next three count as still
+	for (int i = 0; i < 3; ++i)
+		CHECK(!capture.update(corners, ids, frameSize));
+	CHECK(capture.update(corners, ids, frameSize));
+	CHECK(std::isinf(capture.getNovelty()));
+
+	// Motion above stillPixels restarts the count, jitter below it does not
+	capture.reset();
+	CHECK(!capture.update(corners, ids, frameSize));
+	CHECK(!capture.update(corners, ids, frameSize));
+	board(0.2f, 0, corners, ids);
+	CHECK(!capture.update(corners, ids, frameSize));
+	board(2, 0, corners, ids);
+	CHECK(!capture.update(corners, ids, frameSize));
+	CHECK(!capture.update(corners, ids, frameSize));
+	CHECK(!capture.update(corners, ids, frameSize));
+	CHECK(capture.update(corners, ids, frameSize));
+
+	// Less than 4 corners are never still
+	capture.reset();
+	corners.resize(3);
+	ids.resize(3);
+	for (int i = 0; i < 6; ++i)
+		CHECK(!capture.update(corners, ids, frameSize));
+}
+
+static void testNovelty()
+{
+	AutoCapture capture(0.05, 1, 0.5);
+	std::vector<Point2f> corners;
+	std::vector<int> ids;
+	board(0, 0, corners, ids);
+
+	CHECK(!capture.update(corners, ids, frameSize));
+	CHECK(capture.update(corners, ids, frameSize));
+	capture.accept(corners, ids);
+	CHECK(capture.getAccepted() == 1);
+
+	// The accepted view itself is not new
+	CHECK(!capture.update(corners, ids, frameSize));
+	CHECK(!capture.update(corners, ids, frameSize));
+	CHECK_NEAR(capture.getNovelty(), 0, 1e-9);
+
+	// 30 pixels is 3% of the diagonal, 100 pixels is 10%
+	capture.reset();
+	board(30, 0, corners, ids);
+	CHECK(!capture.update(corners, ids, frameSize));
+	CHECK(!capture.update(corners, ids, frameSize));
+	CHECK_NEAR(capture.getNovelty(), 0.03, 1e-6);
+
+	capture.reset();
+	board(60, 80, corners, ids);
+	CHECK(!capture.update(corners, ids, frameSize));
+	CHECK(capture.update(corners, ids, frameSize));
+	CHECK_NEAR(capture.getNovelty(), 0.1, 1e-6);
+
+	// Novelty is the distance to the closest accepted view
+	capture.accept(corners, ids);
+	board(50, 80, corners, ids);
+	CHECK(!capture.update(corners, ids, frameSize));
+	CHECK(!capture.update(corners, ids, frameSize));
+	CHECK_NEAR(capture.getNovelty(), 0.01, 1e-6);
+
+	// Corners that no accepted view shares make the view new
+	capture.reset();
+	board(0, 0, corners, ids, 16);
+	CHECK(!capture.update(corners, ids, frameSize));
+	CHECK(capture.update(corners, ids, frameSize));
+	CHECK(std::isinf(capture.getNovelty()));
+
+	// Without a minimum novelty every still view is taken
+	capture.accept(corners, ids);
+	capture.setMinNovelty(0);
+	CHECK(!capture.update(corners, ids, frameSize));
+	CHECK(capture.update(corners, ids, frameSize));
+	CHECK_NEAR(capture.getNovelty(), 0, 1e-9);
+}
+
+int main()
+{
+	testStill();
+	testNovelty();
+
+	std::cout << "AutoCaptureTest passed" << std::endl;
+	return 0;
+}
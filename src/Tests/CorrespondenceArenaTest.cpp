@@ -0,0 +1,84 @@
+#include <opencv2/core.hpp>
+#include "CorrespondenceArena.h"
+#include "TestUtils.h"
+
+using namespace cv;
+
+static std::vector<Point3f> board()
+{
+	std::vector<Point3f> points;
+	for (int i = 0; i < 6; ++i)
+		points.push_back(Point3f{ (float)(i % 3), (float)(i / 3), 0 });
+	return points;
+}
+
+static std::vector<Point3f> partialBoard(float z)
+{
+	std::vector<Point3f> points = board();
+	for (auto& p : points)
+		p.z = z;
+	return points;
+}
+
+static std::vector<Point2f> image(int count, float offset)
+{
+	std::vector<Point2f> points;
+	for (int i = 0; i < count; ++i)
+		points.push_back(Point2f{ offset + i, offset - i });
+	return points;
+}
+
+static bool equal(const Mat& a, const Mat& b)
+{
+	return a.total() == b.total() && a.type() == b.type() && norm(a.reshape(1), b.reshape(1), NORM_INF) == 0;
+}
+
+int main()
+{
+	CorrespondenceArena arena({ 3, 2 });
+	arena.setBoard(0, board());
+	CHECK(arena.empty());
+
+	// Views that hold the whole board share its points
+	arena.store(0, { Mat(board()), Mat(image(6, 0)) });
+	arena.store(1, { Mat(board()), Mat(image(6, 10)) });
+	arena.store(2, { Mat(partialBoard(1)), Mat(image(6, 20)) });
+	CHECK(arena.size() == 3);
+	CHECK(arena.getPoints(0, 0).data == arena.getPoints(1, 0).data);
+	CHECK(arena.getPoints(2, 0).data != arena.getPoints(0, 0).data);
+	CHECK(equal(arena.getPoints(1, 1), Mat(image(6, 10))));
+	CHECK(equal(arena.getPoints(2, 0), Mat(partialBoard(1))));
+
+	// Replacing in place, with a view of another size, and a stored view by the shared board
+	std::vector<Point3f> corners = board();
+	corners.resize(4);
+	arena.store(0, { Mat(partialBoard(2)), Mat(image(6, 30)) });
+	arena.store(1, { Mat(corners), Mat(image(4, 40)) });
+	arena.store(2, { Mat(board()), Mat(image(6, 50)) });
+	CHECK(equal(arena.getPoints(0, 0), Mat(partialBoard(2))));
+	CHECK(equal(arena.getPoints(0, 1), Mat(image(6, 30))));
+	CHECK(arena.getPoints(1, 0).total() == 4);
+	CHECK(equal(arena.getPoints(1, 1), Mat(image(4, 40))));
+	CHECK(equal(arena.getPoints(2, 0), Mat(board())));
+	CHECK(equal(arena.getPoints(2, 1), Mat(image(6, 50))));
+
+	// Removing most views compacts the arena, the other views keep their points and order
+	arena.store(3, { Mat(partialBoard(3)), Mat(image(6, 60)) });
+	arena.remove({ 2, 0, 1 });
+	CHECK(arena.size() == 1);
+	CHECK(equal(arena.getPoints(0, 0), Mat(partialBoard(3))));
+	CHECK(equal(arena.getPoints(0, 1), Mat(image(6, 60))));
+
+	arena.store(1, { Mat(board()), Mat(image(6, 70)) });
+	std::vector<Mat> selected = arena.getSet(1, { 1, 0 });
+	CHECK(selected.size() == 2);
+	CHECK(equal(selected[0], Mat(image(6, 70))));
+	CHECK(equal(selected[1], Mat(image(6, 60))));
+	CHECK(arena.getSet(0).size() == 2);
+
+	arena.clear();
+	CHECK(arena.empty());
+
+	std::cout << "CorrespondenceArenaTest passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,109 @@
+#include <filesystem>
+#include <opencv2/core.hpp>
+#include "CorrespondenceStore.h"
+#include "TestUtils.h"
+
+using namespace cv;
+
+static std::vector<Point3f> boardPoints(int count, float offset)
+{
+	std::vector<Point3f> points;
+	for (int i = 0; i < count; ++i)
+		points.push_back(Point3f{ (float)i, offset, 0.5f * i });
+	return points;
+}
+
+static std::vector<Point2f> imagePoints(int count, float offset)
+{
+	std::vector<Point2f> points;
+	for (int i = 0; i < count; ++i)
+		points.push_back(Point2f{ offset + i, 2.0f * i });
+	return points;
+}
+
+static bool equal(const Mat& a, const Mat& b)
+{
+	return a.total() == b.total() && a.type() == b.type() && (a.total() == 0 || norm(a, b, NORM_INF) == 0);
+}
+
+static void testRoundTrip(const std::string& fileName)
+{
+	CorrespondenceWriter writer;
+	CHECK(writer.open(fileName, { 3, 2 }));
+	CHECK(writer.write(3, Size(640, 480), { Mat(boardPoints(4, 1)), Mat(imagePoints(4, 1)) }));
+	CHECK(writer.write(8, Size(640, 480), { Mat(boardPoints(2, 2)), Mat(imagePoints(2, 2)) }));
+	// A capture forced without a detection only keeps its id
+	CHECK(writer.write(9, Size(640, 480), { Mat(0, 1, CV_32FC3), Mat(0, 1, CV_32FC2) }));
+	// Point sets of different sizes are refused
+	CHECK(!writer.write(10, Size(640, 480), { Mat(boardPoints(3, 3)), Mat(imagePoints(2, 3)) }));
+	CHECK(writer.getViews() == 3);
+	writer.close();
+
+	CorrespondenceStore store;
+	CHECK(store.open(fileName, { 3, 2 }));
+	CHECK(store.size() == 3);
+	CHECK(store.getId(0) == 3);
+	CHECK(store.getId(1) == 8);
+	CHECK(store.getId(2) == 9);
+	CHECK(store.getFrameSize(1) == Size(640, 480));
+	CHECK(equal(store.getPoints(0, 0), Mat(boardPoints(4, 1))));
+	CHECK(equal(store.getPoints(0, 1), Mat(imagePoints(4, 1))));
+	CHECK(equal(store.getPoints(1, 0), Mat(boardPoints(2, 2))));
+	CHECK(equal(store.getPoints(1, 1), Mat(imagePoints(2, 2))));
+	CHECK(store.getPoints(2, 0).empty());
+
+	// Another calibration's point sets do not match
+	CorrespondenceStore other;
+	CHECK(!other.open(fileName, { 3, 2, 2 }));
+}
+
+static void testInterruptedAppend(const std::string& fileName)
+{
+	size_t complete;
+	{
+		CorrespondenceStore store;
+		CHECK(store.open(fileName, { 3, 2 }));
+		complete = store.getValidLength();
+	}
+
+	// A write that was cut off in the middle of a view
+	{
+		CorrespondenceWriter writer;
+		CHECK(writer.open(fileName, { 3, 2 }, true));
+		CHECK(writer.write(10, Size(640, 480), { Mat(boardPoints(3, 3)), Mat(imagePoints(3, 3)) }));
+	}
+	std::filesystem::resize_file(fileName, std::filesystem::file_size(fileName) - 5);
+	{
+		CorrespondenceStore store;
+		CHECK(store.open(fileName, { 3, 2 }));
+		CHECK(store.size() == 3);
+		CHECK(store.getValidLength() == complete);
+	}
+
+	// Appending continues after the last complete view
+	CorrespondenceWriter writer;
+	CHECK(writer.open(fileName, { 3, 2 }, true));
+	CHECK(writer.getViews() == 3);
+	CHECK(writer.write(11, Size(640, 480), { Mat(boardPoints(3, 4)), Mat(imagePoints(3, 4)) }));
+	writer.close();
+
+	CorrespondenceStore store;
+	CHECK(store.open(fileName, { 3, 2 }));
+	CHECK(store.size() == 4);
+	CHECK(store.getValidLength() == std::filesystem::file_size(fileName));
+	CHECK(store.getId(3) == 11);
+	CHECK(equal(store.getPoints(3, 1), Mat(imagePoints(3, 4))));
+}
+
+int main()
+{
+	std::string folder = makeTestFolder("CorrespondenceStore");
+	std::string fileName = folder + "/views.bin";
+
+	testRoundTrip(fileName);
+	testInterruptedAppend(fileName);
+
+	std::filesystem::remove_all(folder);
+	std::cout << "CorrespondenceStoreTest passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,105 @@
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include "Config.h"
+#include "FrameArchiver.h"
+#include "PackedRecording.h"
+#include "TestUtils.h"
+
+using namespace cv;
+
+static bool equal(const Mat& a, const Mat& b)
+{
+	return a.size() == b.size() && a.type() == b.type() && norm(a, b, NORM_INF) == 0;
+}
+
+static Mat randomFrame(int rows, int cols, int type, uint64 seed)
+{
+	RNG rng(seed);
+	Mat frame(rows, cols, type);
+	rng.fill(frame, RNG::UNIFORM, 0, 256);
+	return frame;
+}
+
+static void testFormats()
+{
+	FrameArchiver archiver;
+	CHECK(!archiver.setFormat("jpg"));
+	CHECK(!archiver.setFormat("png", 10));
+	CHECK(archiver.setFormat("bmp"));
+	CHECK(!archiver.isOpened());
+}
+
+static void testImages(const std::string& folder, const std::string& format)
+{
+	std::string captures = folder + "/" + format;
+	std::vector<Mat> frames{ randomFrame(40, 60, CV_8UC3, 1), randomFrame(40, 60, CV_8UC1, 2), randomFrame(40, 60, CV_8UC3, 3) };
+	std::vector<int> ids{ 0, 3, 12 };
+
+	FrameArchiver archiver;
+	CHECK(archiver.setFormat(format, 9));
+	CHECK(archiver.open(captures, false, false, 1));
+	CHECK(archiver.isOpened());
+	for (size_t i = 0; i < frames.size(); ++i)
+		archiver.submit(ids[i], frames[i]);
+
+	// The archiver keeps a copy, changing the frame afterwards does not change the capture
+	Mat written = frames[2].clone();
+	frames[2].setTo(Scalar::all(0));
+	frames[2] = written;
+
+	archiver.submit(20, Mat());
+	archiver.close();
+	CHECK(!archiver.isOpened());
+
+	CHECK(equal(imread(captures + "/00." + format, IMREAD_UNCHANGED), frames[0]));
+	CHECK(equal(imread(captures + "/03." + format, IMREAD_UNCHANGED), frames[1]));
+	CHECK(equal(imread(captures + "/12." + format, IMREAD_UNCHANGED), frames[2]));
+	CHECK(!std::filesystem::exists(captures + "/20." + format));
+}
+
+static void testPacked(const std::string& folder)
+{
+	std::string captures = folder + "/packed";
+	Mat color = randomFrame(30, 50, CV_8UC3, 4);
+	Mat gray = randomFrame(30, 50, CV_8UC1, 5);
+
+	FrameArchiver archiver;
+	CHECK(archiver.open(captures, true));
+	archiver.submit(0, color);
+	archiver.submit(1, gray);
+	archiver.close();
+
+	// Appending keeps the captures of the first session
+	Mat more = randomFrame(30, 50, CV_8UC1, 6);
+	CHECK(archiver.open(captures, true, true));
+	archiver.submit(2, more);
+	archiver.close();
+
+	// Packed captures are stored as raw grayscale frames
+	PackedRecording recording;
+	CHECK(recording.open(captures + "/" + Config::packedRecordingFile));
+	CHECK(recording.size() == 3);
+
+	Mat expected;
+	cvtColor(color, expected, COLOR_BGR2GRAY);
+	CHECK(recording.getId(0) == 0 && equal(recording.getFrame(0), expected));
+	CHECK(recording.getId(1) == 1 && equal(recording.getFrame(1), gray));
+	CHECK(recording.getId(2) == 2 && equal(recording.getFrame(2), more));
+}
+
+int main()
+{
+	std::string folder = makeTestFolder("FrameArchiver");
+
+	testFormats();
+	testImages(folder, "png");
+	testImages(folder, "bmp");
+	testImages(folder, "tiff");
+	testPacked(folder);
+
+	std::filesystem::remove_all(folder);
+
+	std::cout << "FrameArchiverTest passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,63 @@
+#include <opencv2/core.hpp>
+#include "GrayCodePattern.h"
+#include "TestUtils.h"
+
+using namespace cv;
+
+// The camera sees the projector one to one, with less contrast and an offset, and a shadow over part of the image
+static std::vector<Mat> capture(const std::vector<Mat>& patterns, const Rect& shadow)
+{
+	std::vector<Mat> frames;
+	for (const auto& pattern : patterns)
+	{
+		Mat frame;
+		pattern.convertTo(frame, CV_8U, 0.7, 30);
+		frame(shadow).setTo(40);
+		frames.push_back(frame);
+	}
+	return frames;
+}
+
+static void testDecode(const Size& resolution, int lineShift)
+{
+	GrayCodePattern pattern(resolution, lineShift);
+	std::vector<Mat> patterns = pattern.generate();
+	CHECK((int)patterns.size() == pattern.getNrPatterns());
+
+	Rect shadow(0, 0, 5, 4);
+	Mat projCoords, valid;
+	CHECK(pattern.decode(capture(patterns, shadow), projCoords, valid));
+	CHECK(projCoords.type() == CV_32FC2 && projCoords.size() == resolution);
+
+	for (int y = 0; y < resolution.height; ++y)
+	{
+		for (int x = 0; x < resolution.width; ++x)
+		{
+			if (shadow.contains(Point(x, y)))
+			{
+				CHECK(valid.at<uchar>(y, x) == 0);
+				continue;
+			}
+
+			CHECK(valid.at<uchar>(y, x) != 0);
+			CHECK_NEAR(projCoords.at<Vec2f>(y, x)[0], x, 1e-4);
+			CHECK_NEAR(projCoords.at<Vec2f>(y, x)[1], y, 1e-4);
+		}
+	}
+}
+
+int main()
+{
+	// Resolutions that are not a multiple of the stripes, with and without line shifts
+	testDecode(Size(67, 45), 1);
+	testDecode(Size(100, 37), 8);
+
+	GrayCodePattern pattern(Size(32, 16), 4);
+	std::vector<Mat> frames = pattern.generate();
+	frames.pop_back();
+	Mat projCoords, valid;
+	CHECK(!pattern.decode(frames, projCoords, valid));
+
+	std::cout << "GrayCodePatternTest passed" << std::endl;
+	return 0;
+}
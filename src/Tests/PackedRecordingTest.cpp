@@ -0,0 +1,227 @@
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <opencv2/core.hpp>
+#include "Config.h"
+#include "PackedRecording.h"
+#include "TestUtils.h"
+#include "Utils.h"
+
+using namespace cv;
+
+static bool equal(const Mat& a, const Mat& b)
+{
+	return a.size() == b.size() && a.type() == b.type() && norm(a, b, NORM_INF) == 0;
+}
+
+static Mat randomFrame(int rows, int cols, int type, uint64 seed)
+{
+	RNG rng(seed);
+	Mat frame(rows, cols, type);
+	rng.fill(frame, RNG::UNIFORM, 0, 256);
+	return frame;
+}
+
+static void testRawRoundTrip(const std::string& folder)
+{
+	std::string fileName = folder + "/raw.pack";
+	std::vector<Mat> frames{ randomFrame(48, 67, CV_8UC1, 1), randomFrame(48, 67, CV_8UC1, 2), randomFrame(31, 5, CV_8UC1, 3) };
+	std::vector<int> ids{ 0, 1, 5 };
+
+	PackedRecordingWriter writer;
+	CHECK(writer.open(fileName, PackedRecording::RAW));
+	for (size_t i = 0; i < frames.size(); ++i)
+		CHECK(writer.write(ids[i], frames[i]));
+	writer.close();
+
+	PackedRecording recording;
+	CHECK(recording.open(fileName));
+	CHECK(recording.size() == 3);
+	for (size_t i = 0; i < frames.size(); ++i)
+	{
+		CHECK(recording.getId(i) == ids[i]);
+		Mat frame = recording.getFrame(i);
+		CHECK(equal(frame, frames[i]));
+
+		// RAW frames are views of the mapping at aligned offsets
+		CHECK((uintptr_t)frame.data % 64 == 0);
+	}
+	CHECK(recording.find(5) == 2);
+	CHECK(recording.find(3) == -1);
+}
+
+static void testColorPng(const std::string& folder)
+{
+	std::string fileName = folder + "/png.pack";
+	Mat frame = randomFrame(20, 30, CV_8UC3, 4);
+
+	PackedRecordingWriter writer;
+	CHECK(writer.open(fileName, PackedRecording::PNG, false));
+	CHECK(writer.write(7, frame));
+	writer.close();
+
+	PackedRecording recording;
+	CHECK(recording.open(fileName));
+	CHECK(recording.size() == 1);
+	CHECK(equal(recording.getFrame(0), frame));
+}
+
+static void testAppend(const std::string& folder)
+{
+	std::string fileName = folder + "/" + Config::packedRecordingFile;
+	Mat first = randomFrame(16, 16, CV_8UC1, 5);
+	Mat second = randomFrame(16, 16, CV_8UC1, 6);
+
+	PackedRecordingWriter writer;
+	CHECK(writer.open(fileName));
+	CHECK(writer.write(0, first));
+	writer.close();
+
+	CHECK(writer.open(fileName, PackedRecording::RAW, true, true));
+	CHECK(writer.write(1, second));
+	writer.close();
+
+	PackedRecording recording;
+	CHECK(recording.open(fileName));
+	CHECK(recording.size() == 2);
+	CHECK(equal(recording.getFrame(recording.find(0)), first));
+	CHECK(equal(recording.getFrame(recording.find(1)), second));
+
+	// The loaders read the pack of a folder as "<pack>#<id>" entries in id order
+	std::vector<std::string> entries = Utils::loadImages(folder);
+	CHECK(entries.size() == 2);
+	CHECK(entries[0] == fileName + "#0");
+	CHECK(entries[1] == fileName + "#1");
+	CHECK(equal(Utils::readImage(entries[1], true), second));
+	CHECK(Utils::readImage(fileName + "#2", true).empty());
+}
+
+static void testInterrupted(const std::string& folder)
+{
+	// Copies of a pack that is still being written stand in for a recording that was interrupted
+	std::string fileName = folder + "/interrupted.pack";
+	std::string copy = folder + "/copy.pack";
+	std::vector<Mat> frames;
+	for (int i = 0; i < 150; ++i)
+		frames.push_back(randomFrame(9, 7, CV_8UC1, 100 + i));
+
+	auto checkCopy = [&](int count)
+	{
+		std::filesystem::copy_file(fileName, copy, std::filesystem::copy_options::overwrite_existing);
+		PackedRecording recording;
+		CHECK(recording.open(copy));
+		CHECK(recording.size() == count);
+		for (int i = 0; i < count; ++i)
+			CHECK(recording.getId(i) == i && equal(recording.getFrame(i), frames[i]));
+	};
+
+	PackedRecordingWriter writer;
+	CHECK(writer.open(fileName));
+	checkCopy(0);
+	for (int i = 0; i < 100; ++i)
+	{
+		CHECK(writer.write(i, frames[i]));
+		checkCopy(i + 1);
+	}
+	writer.close();
+
+	// Appending never overwrites the frames of the earlier session
+	CHECK(writer.open(fileName, PackedRecording::RAW, true, true));
+	for (int i = 100; i < 150; ++i)
+	{
+		CHECK(writer.write(i, frames[i]));
+		checkCopy(i + 1);
+	}
+
+	// An interrupted recording can be appended to
+	PackedRecordingWriter resumed;
+	CHECK(resumed.open(copy, PackedRecording::RAW, true, true));
+	CHECK(resumed.write(150, randomFrame(9, 7, CV_8UC1, 250)));
+	resumed.close();
+	PackedRecording recording;
+	CHECK(recording.open(copy));
+	CHECK(recording.size() == 151 && recording.getId(150) == 150);
+
+	writer.close();
+	CHECK(recording.open(fileName));
+	CHECK(recording.size() == 150);
+}
+
+static void testCorruptEntry(const std::string& folder)
+{
+	std::string fileName = folder + "/corrupt.pack";
+
+	PackedRecordingWriter writer;
+	CHECK(writer.open(fileName));
+	CHECK(writer.write(0, randomFrame(8, 8, CV_8UC1, 7)));
+	writer.close();
+
+	// Point the entry behind the end of the file
+	PackedRecordingHeader header;
+	{
+		std::fstream file(fileName, std::ios::in | std::ios::out | std::ios::binary);
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+		uint64_t offset = 1 << 30;
+		file.seekp(header.indexOffset + offsetof(PackedRecordingEntry, offset));
+		file.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+	}
+
+	PackedRecording recording;
+	CHECK(recording.open(fileName));
+	CHECK(recording.getFrame(0).empty());
+
+	// A header without an index is refused
+	std::string unclosed = folder + "/unclosed.pack";
+	{
+		std::ofstream file(unclosed, std::ios::binary);
+		PackedRecordingHeader empty{};
+		file.write(reinterpret_cast<const char*>(&empty), sizeof(empty));
+	}
+	CHECK(!recording.open(unclosed));
+}
+
+static void testCorruptHeader(const std::string& folder)
+{
+	std::string fileName = folder + "/header.pack";
+
+	// An index larger than the file, and an index offset that wraps the bound check
+	std::vector<std::pair<uint32_t, uint64_t>> corruptions{ { 0xffffffffu, 0 }, { 1, ~0ull - 8 } };
+	for (const auto& corruption : corruptions)
+	{
+		PackedRecordingWriter writer;
+		CHECK(writer.open(fileName));
+		CHECK(writer.write(0, randomFrame(8, 8, CV_8UC1, 8)));
+		writer.close();
+
+		{
+			std::fstream file(fileName, std::ios::in | std::ios::out | std::ios::binary);
+			PackedRecordingHeader header;
+			file.read(reinterpret_cast<char*>(&header), sizeof(header));
+			header.frameCount = corruption.first;
+			if (corruption.second != 0)
+				header.indexOffset = corruption.second;
+			file.seekp(0);
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		}
+
+		PackedRecording recording;
+		CHECK(!recording.open(fileName));
+		CHECK(!writer.open(fileName, PackedRecording::RAW, true, true));
+	}
+}
+
+int main()
+{
+	std::string folder = makeTestFolder("PackedRecording");
+
+	testRawRoundTrip(folder);
+	testColorPng(folder);
+	testAppend(folder);
+	testInterrupted(folder);
+	testCorruptEntry(folder);
+	testCorruptHeader(folder);
+
+	std::filesystem::remove_all(folder);
+	std::cout << "PackedRecordingTest passed" << std::endl;
+	return 0;
+}
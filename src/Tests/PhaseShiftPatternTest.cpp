@@ -0,0 +1,67 @@
+#include <opencv2/core.hpp>
+#include "PhaseShiftPattern.h"
+#include "TestUtils.h"
+
+using namespace cv;
+
+// The camera sees the projector one to one, with less contrast and an offset, and a shadow over part of the image
+static std::vector<Mat> capture(const std::vector<Mat>& patterns, const Rect& shadow)
+{
+	std::vector<Mat> frames;
+	for (const auto& pattern : patterns)
+	{
+		Mat frame;
+		pattern.convertTo(frame, CV_8U, 0.7, 30);
+		frame(shadow).setTo(40);
+		frames.push_back(frame);
+	}
+	return frames;
+}
+
+static void testDecode(const Size& resolution, int steps, int period, int periodRatio)
+{
+	PhaseShiftPattern pattern(resolution, steps, period, periodRatio);
+	std::vector<Mat> patterns = pattern.generate();
+	CHECK((int)patterns.size() == pattern.getNrPatterns());
+
+	Rect shadow(resolution.width - 6, resolution.height - 5, 6, 5);
+	Mat projCoords, valid;
+	CHECK(pattern.decode(capture(patterns, shadow), projCoords, valid));
+	CHECK(projCoords.type() == CV_32FC2 && projCoords.size() == resolution);
+
+	for (int y = 0; y < resolution.height; ++y)
+	{
+		for (int x = 0; x < resolution.width; ++x)
+		{
+			if (shadow.contains(Point(x, y)))
+			{
+				CHECK(valid.at<uchar>(y, x) == 0);
+				continue;
+			}
+
+			// At coordinate 0 the phase can wrap to just below a full period, which is rejected as outside of the projector
+			if (x == 0 || y == 0)
+				continue;
+
+			CHECK(valid.at<uchar>(y, x) != 0);
+			CHECK_NEAR(projCoords.at<Vec2f>(y, x)[0], x, 0.05);
+			CHECK_NEAR(projCoords.at<Vec2f>(y, x)[1], y, 0.05);
+		}
+	}
+}
+
+int main()
+{
+	// Two and three periods per axis, the rows span several decode tiles
+	testDecode(Size(100, 70), 4, 16, 8);
+	testDecode(Size(200, 90), 3, 8, 4);
+
+	PhaseShiftPattern pattern(Size(32, 16));
+	std::vector<Mat> frames = pattern.generate();
+	frames.pop_back();
+	Mat projCoords, valid;
+	CHECK(!pattern.decode(frames, projCoords, valid));
+
+	std::cout << "PhaseShiftPatternTest passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,84 @@
+#include <chrono>
+#include <thread>
+#include <opencv2/core.hpp>
+#include "SettleDetector.h"
+#include "TestUtils.h"
+
+using namespace cv;
+
+// Line shift pattern: one pixel wide lines every 8 columns, at column offset shift
+static Mat lines(int shift)
+{
+	Mat frame = Mat::zeros(480, 640, CV_8U);
+	for (int x = shift; x < frame.cols; x += 8)
+		frame.col(x).setTo(255);
+	return frame;
+}
+
+static void testFullResolution()
+{
+	SettleDetector detector(2, 0, 0);
+	detector.reset(lines(0));
+
+	CHECK(!detector.update(lines(0)));
+	CHECK(!detector.hasChanged());
+
+	// Changed on the first shifted frame, settled after two more frames that agree with it
+	CHECK(!detector.update(lines(1)));
+	CHECK(detector.hasChanged());
+	CHECK(!detector.update(lines(1)));
+	CHECK(detector.update(lines(1)));
+	CHECK(!detector.hasTimedOut());
+	CHECK(detector.getSettleLatency() >= detector.getChangeLatency());
+
+	// A frame that still moves restarts the count
+	detector.reset(lines(1));
+	CHECK(!detector.update(lines(2)));
+	CHECK(!detector.update(lines(2)));
+	CHECK(!detector.update(lines(3)));
+	CHECK(!detector.update(lines(3)));
+	CHECK(detector.update(lines(3)));
+}
+
+static void testSmallCopy()
+{
+	// A 160 pixel wide copy averages 4 columns, a one pixel line shift within them is not seen
+	SettleDetector detector(2, 0, 160);
+	detector.reset(lines(0));
+	for (int i = 0; i < 5; ++i)
+		CHECK(!detector.update(lines(1)));
+	CHECK(!detector.hasChanged());
+
+	// A change of the whole scene is
+	detector.reset(lines(0));
+	Mat white(480, 640, CV_8U, Scalar(255));
+	CHECK(!detector.update(white));
+	CHECK(detector.hasChanged());
+}
+
+static void testTimeout()
+{
+	SettleDetector detector(2, 1000, 0);
+	detector.setTimeout(30);
+	detector.reset(lines(0));
+
+	CHECK(!detector.update(lines(0)));
+	CHECK(!detector.hasChanged());
+	std::this_thread::sleep_for(std::chrono::milliseconds(40));
+
+	// Nothing changed before the timeout, the scene is taken as changed and only has to hold still
+	CHECK(!detector.update(lines(0)));
+	CHECK(detector.hasChanged() && detector.hasTimedOut());
+	CHECK(!detector.update(lines(0)));
+	CHECK(detector.update(lines(0)));
+}
+
+int main()
+{
+	testFullResolution();
+	testSmallCopy();
+	testTimeout();
+
+	std::cout << "SettleDetectorTest passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+// The tests are plain executables run by ctest, a failed check prints where it failed and exits with 1
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) \
+		{ \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl; \
+			std::exit(1); \
+		} \
+	} while (0)
+
+#define CHECK_NEAR(a, b, eps) \
+	do { \
+		double checkA = (a), checkB = (b); \
+		if (!(std::abs(checkA - checkB) <= (eps))) \
+		{ \
+			std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_NEAR(" #a ", " #b ") failed: " << checkA << " vs " << checkB << std::endl; \
+			std::exit(1); \
+		} \
+	} while (0)
+
+// An empty folder under the temp directory, removed again by the test
+inline std::string makeTestFolder(const std::string& name)
+{
+	std::filesystem::path folder = std::filesystem::temp_directory_path() / ("ProcamCalibTests_" + name);
+	std::filesystem::remove_all(folder);
+	std::filesystem::create_directories(folder);
+	return folder.string();
+}
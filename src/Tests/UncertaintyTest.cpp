@@ -0,0 +1,66 @@
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include "TestUtils.h"
+#include "Uncertainty.h"
+
+static const std::vector<double> values{ 1, 2, 4, 7, 11, 16 };
+
+static std::vector<double> solveMean(const std::vector<int>& views)
+{
+	double sum = 0;
+	for (int v : views)
+		sum += values[v];
+	return { sum / views.size() };
+}
+
+// Standard error of the mean, s / sqrt(n)
+static double standardError()
+{
+	double n = values.size();
+	double mean = std::accumulate(values.begin(), values.end(), 0.0) / n;
+	double squares = 0;
+	for (double v : values)
+		squares += (v - mean) * (v - mean);
+	return std::sqrt(squares / (n - 1) / n);
+}
+
+int main()
+{
+	int n = values.size();
+
+	// The jackknife standard deviation of a mean is exactly its standard error
+	std::vector<double> stds = Uncertainty::estimate(Uncertainty::LEAVE_ONE_OUT, n, 100, solveMean);
+	CHECK(stds.size() == 1);
+	CHECK_NEAR(stds[0], standardError(), 1e-9);
+
+	// The bootstrap estimates it as well, with the 1/n instead of the 1/(n - 1) variance
+	stds = Uncertainty::estimate(Uncertainty::BOOTSTRAP, n, 4000, solveMean, 1);
+	CHECK(stds.size() == 1);
+	CHECK_NEAR(stds[0], standardError() * std::sqrt((n - 1.0) / n), 0.05 * standardError());
+
+	// Resamples whose solver fails or throws are left out, the resample without view 0 throws here
+	stds = Uncertainty::estimate(Uncertainty::LEAVE_ONE_OUT, n, 100, [](const std::vector<int>& views)
+	{
+		if (views[0] != 0)
+			throw std::runtime_error("degenerate resample");
+		return solveMean(views);
+	});
+	CHECK(stds.size() == 1);
+
+	// Only the resample without view 0 is solved, one resample gives no spread
+	stds = Uncertainty::estimate(Uncertainty::LEAVE_ONE_OUT, n, 100, [](const std::vector<int>& views)
+	{
+		return views[0] != 0 ? solveMean(views) : std::vector<double>{};
+	});
+	CHECK(stds.empty());
+
+	CHECK(Uncertainty::estimate(Uncertainty::NONE, n, 100, solveMean).empty());
+
+	Uncertainty::Method method;
+	CHECK(Uncertainty::parse("loo", method) && method == Uncertainty::LEAVE_ONE_OUT);
+	CHECK(!Uncertainty::parse("jackknife", method));
+
+	std::cout << "UncertaintyTest passed" << std::endl;
+	return 0;
+}
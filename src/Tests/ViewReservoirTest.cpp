@@ -0,0 +1,112 @@
+#include <opencv2/core.hpp>
+#include "TestUtils.h"
+#include "ViewReservoir.h"
+
+using namespace cv;
+
+static const Size frameSize(640, 480);
+
+// Corners of a small board around center
+static std::vector<Point2f> boardAt(const Point2f& center)
+{
+	return { center + Point2f(-10, -10), center + Point2f(10, -10), center + Point2f(10, 10), center + Point2f(-10, 10) };
+}
+
+static void testUnbounded()
+{
+	ViewReservoir reservoir;
+	for (int i = 0; i < 10; ++i)
+		CHECK(reservoir.offer(boardAt(Point2f(40, 40)), frameSize) == i);
+	CHECK(reservoir.size() == 10);
+	CHECK(reservoir.getSeen() == 10);
+}
+
+static void testCoverage()
+{
+	ViewReservoir reservoir(4);
+	for (int i = 0; i < 4; ++i)
+		CHECK(reservoir.offer(boardAt(Point2f(40, 40)), frameSize) == i);
+
+	// A view in an empty bin replaces one of the views of the full bin
+	int slot = reservoir.offer(boardAt(Point2f(600, 440)), frameSize);
+	CHECK(slot >= 0 && slot < 4);
+	slot = reservoir.offer(boardAt(Point2f(600, 40)), frameSize);
+	CHECK(slot >= 0 && slot < 4);
+
+	CHECK(reservoir.size() == 4);
+	CHECK(reservoir.getSeen() == 6);
+}
+
+static void testRemove()
+{
+	ViewReservoir reservoir(4);
+	for (int i = 0; i < 4; ++i)
+		CHECK(reservoir.offer(boardAt(Point2f(40, 40)), frameSize) == i);
+
+	// Removed slots are free again and the remaining views are renumbered, new views are appended after them
+	reservoir.remove({ 1, 2 });
+	CHECK(reservoir.size() == 2);
+	CHECK(reservoir.offer(boardAt(Point2f(40, 40)), frameSize) == 2);
+	CHECK(reservoir.offer(boardAt(Point2f(40, 40)), frameSize) == 3);
+	CHECK(reservoir.size() == 4);
+
+	// Full again, replacements only return slots that exist
+	for (int i = 0; i < 20; ++i)
+	{
+		int slot = reservoir.offer(boardAt(Point2f(40 + 150 * (i % 4), 40 + 120 * (i / 4 % 4))), frameSize);
+		CHECK(slot >= -1 && slot < 4);
+	}
+	CHECK(reservoir.size() == 4);
+
+	// Without a capacity every view is appended
+	ViewReservoir unbounded;
+	for (int i = 0; i < 5; ++i)
+		unbounded.offer(boardAt(Point2f(40, 40)), frameSize);
+	unbounded.remove({ 4, 0 });
+	CHECK(unbounded.size() == 3);
+	CHECK(unbounded.offer(boardAt(Point2f(40, 40)), frameSize) == 3);
+}
+
+static void testUniform()
+{
+	// Within one bin every view is kept with the same chance, capacity / views
+	const int capacity = 4;
+	const int views = 100;
+	const int runs = 2000;
+	std::vector<int> kept(views, 0);
+	for (int run = 0; run < runs; ++run)
+	{
+		ViewReservoir reservoir(capacity, run);
+		std::vector<int> slots(capacity, -1);
+		for (int v = 0; v < views; ++v)
+		{
+			int slot = reservoir.offer(boardAt(Point2f(320, 240)), frameSize);
+			if (slot >= 0)
+				slots[slot] = v;
+		}
+		for (int v : slots)
+			++kept[v];
+	}
+
+	// 20 views are kept 1600 times on average, compare the first and last views of the stream
+	int first = 0, last = 0;
+	for (int v = 0; v < 20; ++v)
+	{
+		first += kept[v];
+		last += kept[views - 1 - v];
+	}
+	double expected = 20.0 * runs * capacity / views;
+	CHECK_NEAR(first, expected, 0.1 * expected);
+	CHECK_NEAR(last, expected, 0.1 * expected);
+}
+
+int main()
+{
+	testUnbounded();
+	testCoverage();
+	testRemove();
+	testUniform();
+
+	std::cout << "ViewReservoirTest passed" << std::endl;
+	return 0;
+}
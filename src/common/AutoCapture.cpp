@@ -0,0 +1,92 @@
+#include "AutoCapture.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace cv;
+
+AutoCapture::AutoCapture(double minNovelty, int stillFrames, double stillPixels): minNovelty{minNovelty}, stillFrames{stillFrames}, stillPixels{stillPixels}, nrStill{0}, novelty{0}
+{
+}
+
+std::vector<Point2f> AutoCapture::byId(const std::vector<Point2f>& corners, const std::vector<int>& ids)
+{
+	int maxId = -1;
+	for (int id : ids)
+		maxId = std::max(maxId, id);
+
+	float nan = std::numeric_limits<float>::quiet_NaN();
+	std::vector<Point2f> points(maxId + 1, Point2f{ nan, nan });
+	for (size_t i = 0; i < corners.size() && i < ids.size(); ++i)
+	{
+		if (ids[i] >= 0)
+			points[ids[i]] = corners[i];
+	}
+	return points;
+}
+
+double AutoCapture::meanDistance(const std::vector<Point2f>& a, const std::vector<Point2f>& b, int& common)
+{
+	common = 0;
+	double sum = 0;
+	for (size_t i = 0; i < a.size() && i < b.size(); ++i)
+	{
+		if (std::isnan(a[i].x) || std::isnan(b[i].x))
+			continue;
+		sum += norm(a[i] - b[i]);
+		++common;
+	}
+	return common > 0 ? sum / common : 0;
+}
+
+void AutoCapture::setMinNovelty(double minNovelty)
+{
+	this->minNovelty = minNovelty;
+}
+
+bool AutoCapture::update(const std::vector<Point2f>& corners, const std::vector<int>& ids, const Size& frameSize)
+{
+	std::vector<Point2f> current = byId(corners, ids);
+
+	int common;
+	double motion = meanDistance(current, previous, common);
+	if (common >= minCommonCorners && motion < stillPixels)
+		++nrStill;
+	else
+		nrStill = 0;
+	previous = current;
+
+	double diagonal = std::hypot(frameSize.width, frameSize.height);
+
+	novelty = std::numeric_limits<double>::infinity();
+	for (const auto& view : accepted)
+	{
+		double distance = meanDistance(current, view, common);
+		if (common >= minCommonCorners)
+			novelty = std::min(novelty, distance / diagonal);
+	}
+
+	return nrStill >= stillFrames && novelty >= minNovelty;
+}
+
+void AutoCapture::reset()
+{
+	previous.clear();
+	nrStill = 0;
+}
+
+void AutoCapture::accept(const std::vector<Point2f>& corners, const std::vector<int>& ids)
+{
+	accepted.push_back(byId(corners, ids));
+	reset();
+}
+
+double AutoCapture::getNovelty() const
+{
+	return novelty;
+}
+
+int AutoCapture::getAccepted() const
+{
+	return (int)accepted.size();
+}
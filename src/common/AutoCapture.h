@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <opencv2/core.hpp>
+
+// Decides when a live view of the board is worth capturing. The board has to hold still for a few frames, so the
+// capture is not blurred, and has to differ enough from every view accepted so far. Views are compared by the mean
+// distance between their common corners relative to the image diagonal, which covers the position, distance and tilt
+// of the board.
+class AutoCapture
+{
+private:
+	double minNovelty;
+	int stillFrames;
+	double stillPixels;
+
+	// Views with fewer common corners barely overlap and count as novel
+	static const int minCommonCorners = 4;
+
+	// Corners indexed by id, NaN when the corner was not found
+	std::vector<cv::Point2f> previous;
+	std::vector<std::vector<cv::Point2f>> accepted;
+	int nrStill;
+	double novelty;
+
+	static std::vector<cv::Point2f> byId(const std::vector<cv::Point2f>& corners, const std::vector<int>& ids);
+	static double meanDistance(const std::vector<cv::Point2f>& a, const std::vector<cv::Point2f>& b, int& common);
+
+public:
+	AutoCapture(double minNovelty = 0.05, int stillFrames = 3, double stillPixels = 0.5);
+
+	void setMinNovelty(double minNovelty);
+
+	// True once the board held still for stillFrames frames in a view that is novel enough
+	bool update(const std::vector<cv::Point2f>& corners, const std::vector<int>& ids, const cv::Size& frameSize);
+
+	// Forget the previous frame, e.g. when the board is not in view
+	void reset();
+
+	// Adds a captured view, later views are compared to it
+	void accept(const std::vector<cv::Point2f>& corners, const std::vector<int>& ids);
+
+	// Novelty of the last update, relative to the image diagonal
+	double getNovelty() const;
+	int getAccepted() const;
+};
@@ -2,13 +2,23 @@
 
 using namespace cv;
 
-CharucoDetector::CharucoDetector(int rowCount, int colCount, aruco::PredefinedDictionaryType dictionaryType, float squareLength, float markerLength)
+CharucoDetector::CharucoDetector(int rowCount, int colCount, aruco::PredefinedDictionaryType dictionaryType, float squareLength, float markerLength, DetectionPreset::Type preset)
 {
-	aruco::DetectorParameters detectorParams = aruco::DetectorParameters();
-	aruco::CharucoParameters charucoParams = aruco::CharucoParameters();
-	charucoParams.tryRefineMarkers = true;
+	charucoBoard = std::make_shared<cv::aruco::CharucoBoard>(Size(rowCount, colCount), squareLength, markerLength, aruco::getPredefinedDictionary(dictionaryType));
+	createDetector(preset);
+}
+
+CharucoDetector::CharucoDetector(std::shared_ptr<aruco::CharucoBoard> charucoBoard, DetectionPreset::Type preset): charucoBoard{charucoBoard}
+{
+	createDetector(preset);
+}
+
+void CharucoDetector::createDetector(DetectionPreset::Type preset)
+{
+	aruco::DetectorParameters detectorParams;
+	aruco::CharucoParameters charucoParams;
+	DetectionPreset::apply(preset, detectorParams, charucoParams);
 	
-	charucoBoard = std::make_unique<cv::aruco::CharucoBoard>(Size(rowCount, colCount), squareLength, markerLength, aruco::getPredefinedDictionary(dictionaryType));
 	charucoDetector = std::make_unique<cv::aruco::CharucoDetector>(*charucoBoard, charucoParams, detectorParams);
 }
 
@@ -1,15 +1,20 @@
 #pragma once
 #include <opencv2/objdetect/aruco_board.hpp>
 #include <opencv2/objdetect/charuco_detector.hpp>
+#include "DetectionPreset.h"
 
 class CharucoDetector
 {
 private:
 	std::unique_ptr<cv::aruco::CharucoDetector> charucoDetector;
-	std::unique_ptr<cv::aruco::CharucoBoard> charucoBoard;
+	std::shared_ptr<cv::aruco::CharucoBoard> charucoBoard;
+
+	void createDetector(DetectionPreset::Type preset);
 
 public:
-	CharucoDetector(int rowCount = 8, int colCount = 6, cv::aruco::PredefinedDictionaryType dictionaryType = cv::aruco::DICT_5X5_50, float squareLength = 1.65f, float markerLength = 1.65f/2.0f);
+	CharucoDetector(int rowCount = 8, int colCount = 6, cv::aruco::PredefinedDictionaryType dictionaryType = cv::aruco::DICT_5X5_50, float squareLength = 1.65f, float markerLength = 1.65f/2.0f, DetectionPreset::Type preset = DetectionPreset::DEFAULT);
+	// Detector for a board (and dictionary) that is shared with other detectors
+	CharucoDetector(std::shared_ptr<cv::aruco::CharucoBoard> charucoBoard, DetectionPreset::Type preset = DetectionPreset::DEFAULT);
 
 	void detectCharucoCorners(cv::Mat img, std::vector<cv::Point2f>& corners, std::vector<int>& cornerIds);
 	cv::Size getBoardSize();
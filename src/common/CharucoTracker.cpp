@@ -0,0 +1,115 @@
+#include "CharucoTracker.h"
+#include <opencv2/calib3d.hpp>
+#include <opencv2/video/tracking.hpp>
+#include "Utils.h"
+
+using namespace cv;
+
+CharucoTracker::CharucoTracker(std::shared_ptr<CharucoDetector> detector, int redetectInterval, int searchInterval): detector{detector}, redetectInterval{redetectInterval}, searchInterval{searchInterval}, framesSinceDetection{0}, detected{false}
+{
+	for (const auto& p : detector->getObjectPoints())
+		boardPoints.push_back(Point2f{ p.x, p.y });
+}
+
+size_t CharucoTracker::track(const Mat& img, bool flipped)
+{
+	Mat gray;
+	Utils::toGray(img, gray);
+	if (flipped)
+	{
+		Mat flippedGray;
+		flip(gray, flippedGray, 1);
+		gray = flippedGray;
+	}
+
+	bool tracked = !corners.empty() && framesSinceDetection < redetectInterval && trackCorners(gray);
+	bool searching = corners.empty() && !prevGray.empty() && framesSinceDetection + 1 < searchInterval;
+	detected = !tracked && !searching;
+	if (detected)
+	{
+		detector->detectCharucoCorners(gray, corners, ids);
+		framesSinceDetection = 0;
+	}
+	else
+	{
+		++framesSinceDetection;
+	}
+
+	// gray can share its data with the caller's frame
+	gray.copyTo(prevGray);
+
+	return corners.size();
+}
+
+bool CharucoTracker::trackCorners(const Mat& gray)
+{
+	if (prevGray.size() != gray.size())
+		return false;
+
+	std::vector<Point2f> nextCorners;
+	std::vector<uchar> status;
+	std::vector<float> err;
+	calcOpticalFlowPyrLK(prevGray, gray, corners, nextCorners, status, err, Size(21, 21), 3);
+
+	std::vector<Point2f> board, found;
+	std::vector<int> foundIds;
+	for (size_t i = 0; i < nextCorners.size(); ++i)
+	{
+		if (!status[i] || ids[i] < 0 || ids[i] >= (int)boardPoints.size())
+			continue;
+		board.push_back(boardPoints[ids[i]]);
+		found.push_back(nextCorners[i]);
+		foundIds.push_back(ids[i]);
+	}
+
+	if (found.size() < 8)
+		return false;
+
+	// The corners lie on a plane, corners that drifted off the board do not fit the homography
+	std::vector<uchar> inliers;
+	Mat H = findHomography(board, found, RANSAC, 3.0, inliers);
+	if (H.empty())
+		return false;
+
+	std::vector<Point2f> inlierCorners;
+	std::vector<int> inlierIds;
+	for (size_t i = 0; i < found.size(); ++i)
+	{
+		if (inliers[i])
+		{
+			inlierCorners.push_back(found[i]);
+			inlierIds.push_back(foundIds[i]);
+		}
+	}
+
+	if (inlierCorners.size() < 0.8 * corners.size())
+		return false;
+
+	corners = inlierCorners;
+	ids = inlierIds;
+	return true;
+}
+
+void CharucoTracker::reset()
+{
+	corners.clear();
+	ids.clear();
+	prevGray.release();
+	framesSinceDetection = 0;
+	detected = false;
+}
+
+bool CharucoTracker::isDetection() const
+{
+	return detected;
+}
+
+const std::vector<Point2f>& CharucoTracker::getCorners() const
+{
+	return corners;
+}
+
+const std::vector<int>& CharucoTracker::getIds() const
+{
+	return ids;
+}
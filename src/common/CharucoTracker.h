@@ -0,0 +1,42 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "CharucoDetector.h"
+
+// Follows the charuco corners of the previous frame with pyramidal optical flow, so the live loops do not need a full
+// detection on every preview frame. The tracked corners have to agree with a homography of the board, a full detection
+// runs when tracking fails and every redetectInterval frames to pick up corners that came into view. While no board is
+// in view the detection only runs every searchInterval frames.
+class CharucoTracker
+{
+private:
+	std::shared_ptr<CharucoDetector> detector;
+	std::vector<cv::Point2f> boardPoints;
+	int redetectInterval;
+	int searchInterval;
+
+	cv::Mat prevGray;
+	std::vector<cv::Point2f> corners;
+	std::vector<int> ids;
+	int framesSinceDetection;
+	bool detected;
+
+	bool trackCorners(const cv::Mat& gray);
+
+public:
+	CharucoTracker(std::shared_ptr<CharucoDetector> detector, int redetectInterval = 10, int searchInterval = 3);
+
+	// Number of corners of the board found in the frame. The frame is flipped first when the board is seen in a mirror.
+	size_t track(const cv::Mat& img, bool flipped = false);
+
+	// Forget the tracked corners, e.g. after a capture when the board is moved
+	void reset();
+
+	// True when the corners of the last frame come from a full detection of it instead of from tracking
+	bool isDetection() const;
+
+	const std::vector<cv::Point2f>& getCorners() const;
+	const std::vector<int>& getIds() const;
+};
+
@@ -8,5 +8,7 @@ public:
 	inline static const std::string cameraCalibrationFolder = baseFolderEstimation + "camCalib/";
 	inline static const std::string mirrorCalibrationFolder = baseFolderEstimation + "mirrorCalib/";
 	inline static const std::string procamCalibrationFolder = baseFolderEstimation + "procamCalib/";
+	inline static const std::string batchFolder = baseFolderEstimation + "batch/";
+	inline static const std::string packedRecordingFile = "frames.pack";
 };
 
@@ -0,0 +1,150 @@
+#include "CorrespondenceArena.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace cv;
+
+CorrespondenceArena::CorrespondenceArena(const std::vector<int>& setDims): setDims{setDims}, data(setDims.size()), boardSet{-1}, unusedPoints{0}, usedPoints{0}
+{
+}
+
+void CorrespondenceArena::setBoard(int set, const std::vector<Point3f>& boardPoints)
+{
+	CV_Assert(setDims[set] == 3 && views.empty());
+	boardSet = set;
+	board.assign((const float*)boardPoints.data(), (const float*)boardPoints.data() + 3 * boardPoints.size());
+}
+
+bool CorrespondenceArena::isBoard(int set, const Mat& points) const
+{
+	return set == boardSet && points.total() * 3 == board.size() && points.isContinuous()
+		&& std::memcmp(points.ptr<float>(), board.data(), board.size() * sizeof(float)) == 0;
+}
+
+void CorrespondenceArena::store(int view, const std::vector<Mat>& sets)
+{
+	CV_Assert(sets.size() == setDims.size() && view >= 0 && view <= size());
+
+	int count = sets[0].checkVector(setDims[0], CV_32F);
+	for (size_t s = 0; s < sets.size(); ++s)
+		CV_Assert(count >= 0 && sets[s].checkVector(setDims[s], CV_32F) == count && sets[s].isContinuous());
+
+	bool append = view == size();
+	if (append)
+		views.push_back(View{ 0, std::vector<long>(setDims.size(), -1) });
+
+	// A replaced view of the same size is overwritten, otherwise its points go to the end
+	View& v = views[view];
+	bool inPlace = !append && v.count == count;
+	if (!append)
+	{
+		usedPoints -= v.count;
+		if (!inPlace)
+			unusedPoints += v.count;
+	}
+	usedPoints += count;
+	v.count = count;
+	for (size_t s = 0; s < sets.size(); ++s)
+	{
+		if (isBoard(s, sets[s]))
+		{
+			// The points the replaced view had in the arena are not referenced anymore
+			if (inPlace && v.offsets[s] >= 0)
+				unusedPoints += count;
+			v.offsets[s] = -1;
+			continue;
+		}
+
+		size_t floats = (size_t)count * setDims[s];
+		if (!inPlace || v.offsets[s] < 0)
+		{
+			v.offsets[s] = data[s].size();
+			data[s].resize(data[s].size() + floats);
+		}
+		std::memcpy(data[s].data() + v.offsets[s], sets[s].ptr<float>(), floats * sizeof(float));
+	}
+
+	if (unusedPoints > usedPoints)
+		compact();
+}
+
+void CorrespondenceArena::remove(std::vector<int> removed)
+{
+	std::sort(removed.begin(), removed.end());
+	for (auto it = removed.rbegin(); it != removed.rend(); ++it)
+	{
+		unusedPoints += views[*it].count;
+		usedPoints -= views[*it].count;
+		views.erase(views.begin() + *it);
+	}
+
+	if (unusedPoints > usedPoints)
+		compact();
+}
+
+void CorrespondenceArena::clear()
+{
+	for (auto& d : data)
+		d.clear();
+	views.clear();
+	unusedPoints = 0;
+	usedPoints = 0;
+}
+
+void CorrespondenceArena::compact()
+{
+	std::vector<std::vector<float>> compacted(data.size());
+	for (size_t s = 0; s < data.size(); ++s)
+		compacted[s].reserve(usedPoints * setDims[s]);
+
+	for (auto& v : views)
+	{
+		for (size_t s = 0; s < data.size(); ++s)
+		{
+			if (v.offsets[s] < 0)
+				continue;
+
+			const float* begin = data[s].data() + v.offsets[s];
+			v.offsets[s] = compacted[s].size();
+			compacted[s].insert(compacted[s].end(), begin, begin + (size_t)v.count * setDims[s]);
+		}
+	}
+
+	data.swap(compacted);
+	unusedPoints = 0;
+}
+
+int CorrespondenceArena::size() const
+{
+	return views.size();
+}
+
+bool CorrespondenceArena::empty() const
+{
+	return views.empty();
+}
+
+Mat CorrespondenceArena::getPoints(int view, int set) const
+{
+	const View& v = views[view];
+	const float* points = v.offsets[set] < 0 ? board.data() : data[set].data() + v.offsets[set];
+	return Mat(v.count, 1, CV_32FC(setDims[set]), const_cast<float*>(points));
+}
+
+std::vector<Mat> CorrespondenceArena::getSet(int set) const
+{
+	std::vector<Mat> points;
+	points.reserve(views.size());
+	for (int v = 0; v < size(); ++v)
+		points.push_back(getPoints(v, set));
+	return points;
+}
+
+std::vector<Mat> CorrespondenceArena::getSet(int set, const std::vector<int>& selected) const
+{
+	std::vector<Mat> points;
+	points.reserve(selected.size());
+	for (int v : selected)
+		points.push_back(getPoints(v, set));
+	return points;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <opencv2/core.hpp>
+
+// Correspondences of all views in one flat array per point set, e.g. board, projector and camera points, with the
+// offset of every view into them. The points of a view are read as Nx1 CV_32FC2 or CV_32FC3 Mat headers on the arena,
+// which the solvers take as InputArrayOfArrays without copying. Views of the board set that equal the board share
+// its points instead of storing them again.
+class CorrespondenceArena
+{
+private:
+	struct View
+	{
+		int count;
+		std::vector<long> offsets;	// per set, -1 for the shared board
+	};
+
+	std::vector<int> setDims;
+	std::vector<std::vector<float>> data;
+	std::vector<View> views;
+
+	int boardSet;
+	std::vector<float> board;
+
+	// Points of replaced and removed views that are still in the arrays, compacted away once they are the majority
+	size_t unusedPoints;
+	size_t usedPoints;
+
+	bool isBoard(int set, const cv::Mat& points) const;
+	void compact();
+
+public:
+	// setDims: 2 or 3 floats per point for every set
+	CorrespondenceArena(const std::vector<int>& setDims);
+
+	void setBoard(int set, const std::vector<cv::Point3f>& boardPoints);
+
+	// sets are vectors of points wrapped in a Mat, in the order of setDims. Appends when view is size(), otherwise
+	// replaces the points of the view.
+	void store(int view, const std::vector<cv::Mat>& sets);
+	void remove(std::vector<int> views);
+	void clear();
+
+	int size() const;
+	bool empty() const;
+
+	// Headers on the arena, valid until it is changed
+	cv::Mat getPoints(int view, int set) const;
+	std::vector<cv::Mat> getSet(int set) const;
+	std::vector<cv::Mat> getSet(int set, const std::vector<int>& views) const;
+};
@@ -0,0 +1,267 @@
+#include "CorrespondenceStore.h"
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Utils.h"
+
+using namespace cv;
+
+static const char correspondenceMagic[4] = { 'P', 'C', 'C', 'S' };
+static const uint32_t correspondenceVersion = 1;
+static const size_t maxSets = sizeof(CorrespondenceHeader::setDims) / sizeof(uint32_t);
+
+static CorrespondenceHeader makeHeader(const std::vector<int>& setDims)
+{
+	CorrespondenceHeader header{};
+	std::memcpy(header.magic, correspondenceMagic, 4);
+	header.version = correspondenceVersion;
+	header.setCount = setDims.size();
+	for (size_t i = 0; i < setDims.size() && i < maxSets; ++i)
+	{
+		header.setDims[i] = setDims[i];
+	}
+	return header;
+}
+
+CorrespondenceStore::CorrespondenceStore(): data{nullptr}, length{0}, validLength{0}
+{
+}
+
+CorrespondenceStore::~CorrespondenceStore()
+{
+	close();
+}
+
+bool CorrespondenceStore::open(const std::string& fileName, const std::vector<int>& setDims)
+{
+	close();
+
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CorrespondenceHeader))
+	{
+		std::cerr << "[CorrespondenceStore] Error: " << fileName << " is not a correspondence file" << std::endl;
+		::close(fd);
+		return false;
+	}
+
+	length = st.st_size;
+	void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED)
+	{
+		std::cerr << "[CorrespondenceStore] Error: Could not map " << fileName << std::endl;
+		length = 0;
+		return false;
+	}
+	data = static_cast<uint8_t*>(mapped);
+
+	CorrespondenceHeader expected = makeHeader(setDims);
+	if (std::memcmp(data, &expected, sizeof(expected)) != 0)
+	{
+		std::cerr << "[CorrespondenceStore] Error: " << fileName << " is not a correspondence file of this calibration" << std::endl;
+		close();
+		return false;
+	}
+
+	this->setDims = setDims;
+	size_t floatsPerPoint = 0;
+	for (int dims : setDims)
+	{
+		floatsPerPoint += dims;
+	}
+
+	size_t offset = sizeof(CorrespondenceHeader);
+	while (offset + sizeof(CorrespondenceViewHeader) <= length)
+	{
+		const CorrespondenceViewHeader* view = reinterpret_cast<const CorrespondenceViewHeader*>(data + offset);
+		size_t end = offset + sizeof(CorrespondenceViewHeader) + view->pointCount * floatsPerPoint * sizeof(float);
+		if (end > length)
+			break;
+
+		viewOffsets.push_back(offset);
+		offset = end;
+	}
+	validLength = offset;
+
+	if (validLength != length)
+		std::cout << "[CorrespondenceStore] Dropped an incomplete view at the end of " << fileName << std::endl;
+
+	return true;
+}
+
+void CorrespondenceStore::close()
+{
+	if (data != nullptr)
+	{
+		munmap(data, length);
+		data = nullptr;
+		length = 0;
+	}
+	viewOffsets.clear();
+	setDims.clear();
+	validLength = 0;
+}
+
+int CorrespondenceStore::size() const
+{
+	return viewOffsets.size();
+}
+
+int CorrespondenceStore::getId(int view) const
+{
+	return reinterpret_cast<const CorrespondenceViewHeader*>(data + viewOffsets[view])->id;
+}
+
+Size CorrespondenceStore::getFrameSize(int view) const
+{
+	const CorrespondenceViewHeader* header = reinterpret_cast<const CorrespondenceViewHeader*>(data + viewOffsets[view]);
+	return Size(header->cols, header->rows);
+}
+
+Mat CorrespondenceStore::getPoints(int view, int set) const
+{
+	const CorrespondenceViewHeader* header = reinterpret_cast<const CorrespondenceViewHeader*>(data + viewOffsets[view]);
+
+	size_t offset = viewOffsets[view] + sizeof(CorrespondenceViewHeader);
+	for (int i = 0; i < set; ++i)
+	{
+		offset += header->pointCount * setDims[i] * sizeof(float);
+	}
+
+	return Mat(header->pointCount, 1, CV_32FC(setDims[set]), data + offset);
+}
+
+size_t CorrespondenceStore::getValidLength() const
+{
+	return validLength;
+}
+
+CorrespondenceWriter::CorrespondenceWriter(): written{0}, views{0}
+{
+}
+
+CorrespondenceWriter::~CorrespondenceWriter()
+{
+	close();
+}
+
+bool CorrespondenceWriter::open(const std::string& fileName, const std::vector<int>& setDims, bool append)
+{
+	close();
+
+	if (setDims.empty() || setDims.size() > maxSets)
+	{
+		std::cerr << "[CorrespondenceWriter] Error: A correspondence file holds 1 to " << maxSets << " point sets" << std::endl;
+		return false;
+	}
+
+	this->fileName = fileName;
+	this->setDims = setDims;
+	written = 0;
+	views = 0;
+
+	Utils::verifyDirectories(fileName);
+
+	if (append && std::filesystem::exists(fileName))
+	{
+		size_t validLength;
+		{
+			CorrespondenceStore store;
+			if (!store.open(fileName, setDims))
+			{
+				std::cerr << "[CorrespondenceWriter] Error: Could not append to " << fileName << std::endl;
+				return false;
+			}
+			validLength = store.getValidLength();
+			views = store.size();
+		}
+
+		// New views continue after the last complete one
+		std::filesystem::resize_file(fileName, validLength);
+		file.open(fileName, std::ios::out | std::ios::app | std::ios::binary);
+	}
+	else
+	{
+		file.open(fileName, std::ios::out | std::ios::trunc | std::ios::binary);
+
+		CorrespondenceHeader header = makeHeader(setDims);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.flush();
+	}
+
+	if (!file.is_open() || !file)
+	{
+		std::cerr << "[CorrespondenceWriter] Error: Could not open the output file " << fileName << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool CorrespondenceWriter::write(int id, const Size& frameSize, const std::vector<Mat>& sets)
+{
+	if (!isOpened())
+		return false;
+
+	if (sets.size() != setDims.size())
+	{
+		std::cerr << "[CorrespondenceWriter] Expected " << setDims.size() << " point sets, got " << sets.size() << std::endl;
+		return false;
+	}
+
+	CorrespondenceViewHeader view{};
+	view.id = id;
+	view.pointCount = sets[0].total();
+	view.rows = frameSize.height;
+	view.cols = frameSize.width;
+
+	for (size_t i = 0; i < sets.size(); ++i)
+	{
+		if (sets[i].total() != view.pointCount || sets[i].type() != CV_32FC(setDims[i]))
+		{
+			std::cerr << "[CorrespondenceWriter] Point set " << i << " does not match the other sets of the view" << std::endl;
+			return false;
+		}
+	}
+
+	file.write(reinterpret_cast<const char*>(&view), sizeof(view));
+	for (const auto& set : sets)
+	{
+		Mat points = set.isContinuous() ? set : set.clone();
+		file.write(reinterpret_cast<const char*>(points.data), points.total() * points.elemSize());
+	}
+
+	// A session that is interrupted later keeps this view
+	file.flush();
+	++written;
+	++views;
+
+	return (bool)file;
+}
+
+void CorrespondenceWriter::close()
+{
+	if (!isOpened())
+		return;
+
+	file.close();
+	std::cout << "[CorrespondenceWriter] Wrote " << written << " views to " << fileName << std::endl;
+}
+
+bool CorrespondenceWriter::isOpened() const
+{
+	return file.is_open();
+}
+
+int CorrespondenceWriter::getViews() const
+{
+	return views;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+// File layout: header | views
+// Every view holds the same number of points for each of the point sets of the file, e.g. board and image points.
+// Views are appended and flushed one at a time, so the file of an interrupted session holds every completed view.
+struct CorrespondenceHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t setCount;
+	uint32_t setDims[5];	// 2 or 3 floats per point
+};
+
+struct CorrespondenceViewHeader
+{
+	int32_t id;
+	uint32_t pointCount;
+	int32_t rows;			// size of the frame the points were detected in
+	int32_t cols;
+};
+
+class CorrespondenceStore
+{
+public:
+	CorrespondenceStore();
+	~CorrespondenceStore();
+
+	CorrespondenceStore(const CorrespondenceStore&) = delete;
+	CorrespondenceStore& operator=(const CorrespondenceStore&) = delete;
+
+	// Fails when the file does not exist or has different point sets, a view cut off by an interrupted write is dropped
+	bool open(const std::string& fileName, const std::vector<int>& setDims);
+	void close();
+
+	int size() const;
+	int getId(int view) const;
+	cv::Size getFrameSize(int view) const;
+
+	// Nx1 CV_32FC2 or CV_32FC3 on the mapped file, copy it to a vector of points to keep it
+	cv::Mat getPoints(int view, int set) const;
+
+	// Offset of the end of the last complete view
+	size_t getValidLength() const;
+
+private:
+	uint8_t* data;
+	size_t length;
+	std::vector<int> setDims;
+	std::vector<size_t> viewOffsets;
+	size_t validLength;
+};
+
+class CorrespondenceWriter
+{
+private:
+	std::ofstream file;
+	std::string fileName;
+	std::vector<int> setDims;
+	int written;
+	int views;
+
+public:
+	CorrespondenceWriter();
+	~CorrespondenceWriter();
+
+	// Appending to an existing file with other point sets fails
+	bool open(const std::string& fileName, const std::vector<int>& setDims, bool append = false);
+
+	// sets are vectors of Point2f or Point3f wrapped in a Mat, in the order of setDims
+	bool write(int id, const cv::Size& frameSize, const std::vector<cv::Mat>& sets);
+	void close();
+
+	bool isOpened() const;
+
+	// Views in the file, including the ones that were there before appending
+	int getViews() const;
+};
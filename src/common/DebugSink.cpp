@@ -0,0 +1,179 @@
+#include "DebugSink.h"
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/objdetect/charuco_detector.hpp>
+
+using namespace cv;
+
+DebugOverlay DebugOverlay::corners(const Size& patternSize, const std::vector<Point2f>& points)
+{
+	DebugOverlay overlay;
+	overlay.type = CORNERS;
+	overlay.patternSize = patternSize;
+	overlay.points = points;
+	return overlay;
+}
+
+DebugOverlay DebugOverlay::charuco(const std::vector<Point2f>& points, const std::vector<int>& ids, const Scalar& color)
+{
+	DebugOverlay overlay;
+	overlay.type = CHARUCO;
+	overlay.points = points;
+	overlay.ids = ids;
+	overlay.color = color;
+	return overlay;
+}
+
+DebugSink::DebugSink(): toVideo{false}, written{0}, dropped{0}, capacity{32}, stopping{false}
+{
+}
+
+DebugSink::~DebugSink()
+{
+	close();
+}
+
+bool DebugSink::open(const std::string& output, size_t capacity)
+{
+	close();
+
+	this->output = output;
+	this->capacity = capacity;
+	written = 0;
+	dropped = 0;
+	stopping = false;
+
+	std::string extension = std::filesystem::path(output).extension().string();
+	toVideo = extension == ".avi" || extension == ".mp4" || extension == ".mkv";
+
+	std::filesystem::path folder = toVideo ? std::filesystem::path(output).parent_path() : std::filesystem::path(output);
+	if (!folder.empty() && !std::filesystem::exists(folder))
+	{
+		std::filesystem::create_directories(folder);
+	}
+
+	worker = std::thread(&DebugSink::run, this);
+
+	std::cout << "[DebugSink] Writing debug output to " << output << std::endl;
+	return true;
+}
+
+void DebugSink::submit(const std::string& name, const Mat& frame, std::vector<DebugOverlay> overlays)
+{
+	if (!isOpened() || frame.empty())
+		return;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	if (queue.size() >= capacity)
+	{
+		++dropped;
+		return;
+	}
+
+	// The caller keeps using its frame (and may draw on it), only the copy is shared with the writer
+	Item item;
+	item.name = name;
+	frame.copyTo(item.frame);
+	item.overlays = std::move(overlays);
+	queue.push_back(std::move(item));
+
+	lock.unlock();
+	itemAvailable.notify_one();
+}
+
+void DebugSink::run()
+{
+	while (true)
+	{
+		Item item;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			itemAvailable.wait(lock, [this] { return stopping || !queue.empty(); });
+			if (queue.empty())
+				return;
+
+			item = std::move(queue.front());
+			queue.pop_front();
+		}
+
+		write(item);
+	}
+}
+
+void DebugSink::write(Item& item)
+{
+	Mat img;
+	if (item.frame.channels() == 1)
+		cvtColor(item.frame, img, COLOR_GRAY2BGR);
+	else if (item.frame.channels() == 4)
+		cvtColor(item.frame, img, COLOR_BGRA2BGR);
+	else
+		img = item.frame;
+
+	for (const auto& overlay : item.overlays)
+	{
+		if (overlay.type == DebugOverlay::CORNERS)
+			drawChessboardCorners(img, overlay.patternSize, overlay.points, true);
+		else
+			aruco::drawDetectedCornersCharuco(img, overlay.points, overlay.ids, overlay.color);
+	}
+
+	putText(img, item.name, Point(10, 30), FONT_HERSHEY_SIMPLEX, 1.0, Scalar(0, 0, 255), 2);
+
+	if (toVideo)
+	{
+		if (!videoWriter.isOpened())
+		{
+			videoSize = img.size();
+			int fourcc = std::filesystem::path(output).extension() == ".avi" ? VideoWriter::fourcc('M', 'J', 'P', 'G') : VideoWriter::fourcc('m', 'p', '4', 'v');
+			if (!videoWriter.open(output, fourcc, 5.0, videoSize))
+			{
+				std::cerr << "[DebugSink] Error: Could not open the output video " << output << std::endl;
+				return;
+			}
+		}
+
+		if (img.size() != videoSize)
+			resize(img, img, videoSize);
+		videoWriter.write(img);
+	}
+	else
+	{
+		std::stringstream ss;
+		ss << std::setfill('0') << std::setw(5) << written << "_" << item.name << ".png";
+		imwrite((std::filesystem::path(output) / ss.str()).string(), img);
+	}
+
+	++written;
+}
+
+void DebugSink::close()
+{
+	if (!isOpened())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	itemAvailable.notify_one();
+	worker.join();
+
+	if (videoWriter.isOpened())
+		videoWriter.release();
+
+	std::cout << "[DebugSink] Wrote " << written << " debug frames to " << output;
+	if (dropped > 0)
+		std::cout << ", dropped " << dropped << " frames";
+	std::cout << std::endl;
+}
+
+bool DebugSink::isOpened() const
+{
+	return worker.joinable();
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+struct DebugOverlay
+{
+	enum Type
+	{
+		CORNERS,	// drawChessboardCorners of a grid of patternSize
+		CHARUCO		// drawDetectedCornersCharuco with ids
+	};
+
+	Type type;
+	std::vector<cv::Point2f> points;
+	cv::Size patternSize;
+	std::vector<int> ids;
+	cv::Scalar color;
+
+	static DebugOverlay corners(const cv::Size& patternSize, const std::vector<cv::Point2f>& points);
+	static DebugOverlay charuco(const std::vector<cv::Point2f>& points, const std::vector<int>& ids, const cv::Scalar& color = cv::Scalar(0, 255, 0));
+};
+
+// Offscreen replacement for imshow: frames are queued and a background thread draws the overlays and writes
+// them as numbered images to a folder, or to a video when the output ends with .avi, .mp4 or .mkv.
+// Frames are dropped instead of blocking the caller when the writer falls behind.
+class DebugSink
+{
+private:
+	struct Item
+	{
+		std::string name;
+		cv::Mat frame;
+		std::vector<DebugOverlay> overlays;
+	};
+
+	std::string output;
+	bool toVideo;
+	cv::VideoWriter videoWriter;
+	cv::Size videoSize;
+	int written;
+	int dropped;
+
+	size_t capacity;
+	std::deque<Item> queue;
+	std::mutex mutex;
+	std::condition_variable itemAvailable;
+	std::thread worker;
+	bool stopping;
+
+	void run();
+	void write(Item& item);
+
+public:
+	DebugSink();
+	~DebugSink();
+
+	DebugSink(const DebugSink&) = delete;
+	DebugSink& operator=(const DebugSink&) = delete;
+
+	bool open(const std::string& output, size_t capacity = 32);
+	void submit(const std::string& name, const cv::Mat& frame, std::vector<DebugOverlay> overlays = {});
+	void close();
+
+	bool isOpened() const;
+};
+
@@ -0,0 +1,70 @@
+#include "DetectionPreset.h"
+#include <iostream>
+
+using namespace cv;
+
+bool DetectionPreset::parse(const std::string& name, Type& preset)
+{
+	if (name == "realtime")
+		preset = REALTIME;
+	else if (name == "default")
+		preset = DEFAULT;
+	else if (name == "precise")
+		preset = PRECISE;
+	else
+	{
+		std::cerr << "[DetectionPreset] Unknown preset " << name << ", use realtime, default or precise" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+std::string DetectionPreset::name(Type preset)
+{
+	switch (preset)
+	{
+	case REALTIME:
+		return "realtime";
+	case PRECISE:
+		return "precise";
+	default:
+		return "default";
+	}
+}
+
+void DetectionPreset::apply(Type preset, aruco::DetectorParameters& detectorParams, aruco::CharucoParameters& charucoParams)
+{
+	detectorParams = aruco::DetectorParameters();
+	charucoParams = aruco::CharucoParameters();
+	charucoParams.tryRefineMarkers = true;
+
+	if (preset == REALTIME)
+	{
+		// Thresholds the image with windows of 3 and 23 pixels instead of 3, 13 and 23
+		detectorParams.adaptiveThreshWinSizeStep = 20;
+		charucoParams.tryRefineMarkers = false;
+	}
+	else if (preset == PRECISE)
+	{
+		// Windows of 3, 8, 13, .. 33 pixels, markers are refined to subpixel accuracy before the corners are interpolated
+		detectorParams.adaptiveThreshWinSizeMax = 33;
+		detectorParams.adaptiveThreshWinSizeStep = 5;
+		detectorParams.cornerRefinementMethod = aruco::CORNER_REFINE_SUBPIX;
+	}
+}
+
+void DetectionPreset::apply(Type preset, SimpleBlobDetector::Params& blobParams)
+{
+	// SimpleBlobDetector thresholds the image from minThreshold to maxThreshold in thresholdStep steps
+	// and keeps the blobs that are found in at least minRepeatability thresholds
+	if (preset == REALTIME)
+	{
+		blobParams.thresholdStep = 30;
+		blobParams.minRepeatability = 1;
+	}
+	else if (preset == PRECISE)
+	{
+		blobParams.thresholdStep = 5;
+		blobParams.minRepeatability = 3;
+	}
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include <opencv2/features2d.hpp>
+#include <opencv2/objdetect/aruco_detector.hpp>
+#include <opencv2/objdetect/charuco_detector.hpp>
+
+// Named sets of charuco and circle grid detector parameters, meant to trade detection speed for accuracy. Their effect
+// on a recording is measured with DetectionBenchmark.
+class DetectionPreset
+{
+public:
+	enum Type
+	{
+		REALTIME,	// fewer threshold windows and blob thresholds, no marker refinement
+		DEFAULT,	// the parameters the calibration tools always used
+		PRECISE		// more threshold windows and blob thresholds, subpixel marker corners
+	};
+
+	static bool parse(const std::string& name, Type& preset);
+	static std::string name(Type preset);
+
+	static void apply(Type preset, cv::aruco::DetectorParameters& detectorParams, cv::aruco::CharucoParameters& charucoParams);
+	static void apply(Type preset, cv::SimpleBlobDetector::Params& blobParams);
+};
+
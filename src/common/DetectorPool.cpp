@@ -0,0 +1,113 @@
+#include "DetectorPool.h"
+
+using namespace cv;
+
+DetectorPool::DetectorPool(int rowCount, int colCount, aruco::PredefinedDictionaryType dictionaryType, float squareLength, float markerLength)
+{
+	charucoBoard = std::make_shared<aruco::CharucoBoard>(Size(rowCount, colCount), squareLength, markerLength, aruco::getPredefinedDictionary(dictionaryType));
+	idle = std::make_shared<Idle>();
+	idle->preset = DetectionPreset::DEFAULT;
+}
+
+DetectorPool& DetectorPool::global()
+{
+	static DetectorPool pool;
+	return pool;
+}
+
+SimpleBlobDetector::Params DetectorPool::circlesGridParams(DetectionPreset::Type preset)
+{
+	SimpleBlobDetector::Params paramsFrame;
+	paramsFrame.blobColor = 255;
+	paramsFrame.filterByColor = true;
+	paramsFrame.filterByArea = true;
+	paramsFrame.minArea = 20;
+	paramsFrame.filterByConvexity = 0;
+	paramsFrame.filterByInertia = 0;
+	paramsFrame.filterByCircularity = 1;
+	paramsFrame.minDistBetweenBlobs = 5;
+
+	// This parameter really does a lot for RMS
+	//paramsFrame.minThreshold = 200;
+	paramsFrame.minCircularity = 0.5;
+
+	DetectionPreset::apply(preset, paramsFrame);
+
+	return paramsFrame;
+}
+
+void DetectorPool::setPreset(DetectionPreset::Type preset)
+{
+	std::lock_guard<std::mutex> lock(idle->mutex);
+	idle->preset = preset;
+
+	// Idle detectors were made with the previous preset, detectors in use are dropped when they are released
+	idle->charucoDetectors.clear();
+	idle->blobDetectors.clear();
+}
+
+DetectionPreset::Type DetectorPool::getPreset()
+{
+	std::lock_guard<std::mutex> lock(idle->mutex);
+	return idle->preset;
+}
+
+std::shared_ptr<CharucoDetector> DetectorPool::acquireCharucoDetector()
+{
+	std::unique_ptr<CharucoDetector> detector;
+	DetectionPreset::Type preset;
+	{
+		std::lock_guard<std::mutex> lock(idle->mutex);
+		preset = idle->preset;
+		if (!idle->charucoDetectors.empty())
+		{
+			detector = std::move(idle->charucoDetectors.back());
+			idle->charucoDetectors.pop_back();
+		}
+	}
+
+	if (!detector)
+		detector = std::make_unique<CharucoDetector>(charucoBoard, preset);
+
+	std::weak_ptr<Idle> pool = idle;
+	return std::shared_ptr<CharucoDetector>(detector.release(), [pool, preset](CharucoDetector* released)
+	{
+		std::unique_ptr<CharucoDetector> owned(released);
+		if (auto idle = pool.lock())
+		{
+			std::lock_guard<std::mutex> lock(idle->mutex);
+			if (idle->preset == preset)
+				idle->charucoDetectors.push_back(std::move(owned));
+		}
+	});
+}
+
+Ptr<FeatureDetector> DetectorPool::acquireBlobDetector()
+{
+	Ptr<SimpleBlobDetector> detector;
+	DetectionPreset::Type preset;
+	{
+		std::lock_guard<std::mutex> lock(idle->mutex);
+		preset = idle->preset;
+		if (!idle->blobDetectors.empty())
+		{
+			detector = idle->blobDetectors.back();
+			idle->blobDetectors.pop_back();
+		}
+	}
+
+	if (!detector)
+		detector = SimpleBlobDetector::create(circlesGridParams(preset));
+
+	// The deleter keeps the detector alive and puts it back when the last user lets go of it
+	std::weak_ptr<Idle> pool = idle;
+	return Ptr<FeatureDetector>(std::shared_ptr<FeatureDetector>(detector.get(), [pool, preset, detector](FeatureDetector*)
+	{
+		if (auto idle = pool.lock())
+		{
+			std::lock_guard<std::mutex> lock(idle->mutex);
+			if (idle->preset == preset)
+				idle->blobDetectors.push_back(detector);
+		}
+	}));
+}
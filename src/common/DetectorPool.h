@@ -0,0 +1,43 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <opencv2/features2d.hpp>
+#include "CharucoDetector.h"
+
+// Hands out charuco and blob detectors to threads. The detectors are not safe to use from several threads at once,
+// so every caller gets its own instance for as long as it holds the returned pointer, after which the instance goes
+// back to the pool. The board and dictionary are built once and shared by all charuco detectors.
+class DetectorPool
+{
+private:
+	struct Idle
+	{
+		std::mutex mutex;
+		DetectionPreset::Type preset;
+		std::vector<std::unique_ptr<CharucoDetector>> charucoDetectors;
+		std::vector<cv::Ptr<cv::SimpleBlobDetector>> blobDetectors;
+	};
+
+	std::shared_ptr<cv::aruco::CharucoBoard> charucoBoard;
+
+	// Shared with the returned pointers, so detectors released after the pool is gone are simply deleted
+	std::shared_ptr<Idle> idle;
+
+public:
+	DetectorPool(int rowCount = 8, int colCount = 6, cv::aruco::PredefinedDictionaryType dictionaryType = cv::aruco::DICT_5X5_50, float squareLength = 1.65f, float markerLength = 1.65f/2.0f);
+
+	// Pool with the default board, used by the calibrators
+	static DetectorPool& global();
+
+	// Circle grid blob detector parameters used for the projected patterns
+	static cv::SimpleBlobDetector::Params circlesGridParams(DetectionPreset::Type preset = DetectionPreset::DEFAULT);
+
+	// Detectors handed out afterwards use the preset, set it before the calibrators are created
+	void setPreset(DetectionPreset::Type preset);
+	DetectionPreset::Type getPreset();
+
+	std::shared_ptr<CharucoDetector> acquireCharucoDetector();
+	cv::Ptr<cv::FeatureDetector> acquireBlobDetector();
+};
+
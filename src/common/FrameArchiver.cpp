@@ -0,0 +1,145 @@
+#include "FrameArchiver.h"
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <opencv2/imgcodecs.hpp>
+#include "Config.h"
+
+using namespace cv;
+
+FrameArchiver::FrameArchiver(): packed{false}, format{"png"}, compression{1}, written{0}, capacity{64}, stopping{false}
+{
+}
+
+FrameArchiver::~FrameArchiver()
+{
+	close();
+}
+
+bool FrameArchiver::setFormat(const std::string& format, int compression)
+{
+	if (format != "png" && format != "bmp" && format != "tiff")
+	{
+		std::cerr << "[FrameArchiver] Unknown capture format " << format << ", use png, bmp or tiff" << std::endl;
+		return false;
+	}
+	if (compression < 0 || compression > 9)
+	{
+		std::cerr << "[FrameArchiver] The PNG compression level should be between 0 and 9" << std::endl;
+		return false;
+	}
+
+	this->format = format;
+	this->compression = compression;
+	return true;
+}
+
+bool FrameArchiver::open(const std::string& folder, bool packed, bool append, size_t capacity)
+{
+	close();
+
+	this->folder = folder;
+	this->packed = packed;
+	this->capacity = capacity;
+	written = 0;
+	stopping = false;
+
+	if (packed)
+	{
+		if (!packWriter.open(folder + "/" + Config::packedRecordingFile, PackedRecording::RAW, true, append))
+			return false;
+	}
+	else if (!std::filesystem::exists(folder))
+	{
+		std::filesystem::create_directories(folder);
+	}
+
+	worker = std::thread(&FrameArchiver::run, this);
+	return true;
+}
+
+void FrameArchiver::submit(int id, const Mat& frame)
+{
+	if (!isOpened() || frame.empty())
+		return;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	spaceAvailable.wait(lock, [this] { return queue.size() < capacity; });
+
+	// The caller keeps using its frame, and a camera frame goes back to the camera sooner when it is not referenced
+	Item item;
+	item.id = id;
+	frame.copyTo(item.frame);
+	queue.push_back(std::move(item));
+
+	lock.unlock();
+	itemAvailable.notify_one();
+}
+
+void FrameArchiver::run()
+{
+	while (true)
+	{
+		Item item;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			itemAvailable.wait(lock, [this] { return stopping || !queue.empty(); });
+			if (queue.empty())
+				return;
+
+			item = std::move(queue.front());
+			queue.pop_front();
+		}
+		spaceAvailable.notify_one();
+
+		write(item);
+	}
+}
+
+void FrameArchiver::write(const Item& item)
+{
+	if (packed)
+	{
+		packWriter.write(item.id, item.frame);
+		++written;
+		return;
+	}
+
+	std::stringstream ss;
+	ss << std::setfill('0') << std::setw(2) << item.id << "." << format;
+
+	std::vector<int> params;
+	if (format == "png")
+		params = { IMWRITE_PNG_COMPRESSION, compression };
+
+	if (!imwrite(folder + "/" + ss.str(), item.frame, params))
+	{
+		std::cerr << "[FrameArchiver] Error: Could not write " << folder << "/" << ss.str() << std::endl;
+		return;
+	}
+	++written;
+}
+
+void FrameArchiver::close()
+{
+	if (!isOpened())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	itemAvailable.notify_one();
+	worker.join();
+
+	packWriter.close();
+
+	std::cout << "[FrameArchiver] Saved " << written << " captures to " << folder << std::endl;
+}
+
+bool FrameArchiver::isOpened() const
+{
+	return worker.joinable();
+}
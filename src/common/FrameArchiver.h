@@ -0,0 +1,61 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <opencv2/core.hpp>
+#include "PackedRecording.h"
+
+// Saves the captures of a live session on a background thread, so encoding and writing never hold up the next capture
+// or detection. Captures go to numbered images in the recording folder, or to a packed recording in it. Unlike the
+// debug output captures are never dropped, the caller only waits when the writer is capacity captures behind.
+class FrameArchiver
+{
+private:
+	struct Item
+	{
+		int id;
+		cv::Mat frame;
+	};
+
+	std::string folder;
+	bool packed;
+	PackedRecordingWriter packWriter;
+
+	// Lossless image format of the numbered images, and the zlib level of PNG images
+	std::string format;
+	int compression;
+	int written;
+
+	size_t capacity;
+	std::deque<Item> queue;
+	std::mutex mutex;
+	std::condition_variable itemAvailable;
+	std::condition_variable spaceAvailable;
+	std::thread worker;
+	bool stopping;
+
+	void run();
+	void write(const Item& item);
+
+public:
+	FrameArchiver();
+	~FrameArchiver();
+
+	FrameArchiver(const FrameArchiver&) = delete;
+	FrameArchiver& operator=(const FrameArchiver&) = delete;
+
+	// png, bmp or tiff. The compression level (0-9) only applies to png, bmp is not compressed and the fastest to write.
+	// Packed captures are always stored raw, so they can be read without decoding.
+	bool setFormat(const std::string& format, int compression = 1);
+
+	// The folder is created here once. A packed recording is appended to when append is set.
+	bool open(const std::string& folder, bool packed, bool append = false, size_t capacity = 64);
+	void submit(int id, const cv::Mat& frame);
+
+	// Waits until every submitted capture is written
+	void close();
+
+	bool isOpened() const;
+};
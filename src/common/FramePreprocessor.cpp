@@ -0,0 +1,122 @@
+#include "FramePreprocessor.h"
+#include <cstring>
+#include <opencv2/imgproc.hpp>
+
+using namespace cv;
+
+// BGR to gray weights of cvtColor in Q14, gaussian kernel (ksize 3, sigma 1) in Q8
+static const uint32_t weightB = 1868, weightG = 9617, weightR = 4899;
+static const uint32_t kernelSide = 70, kernelCenter = 116;
+
+FramePreprocessor::FramePreprocessor()
+{
+}
+
+void FramePreprocessor::convertRow(const Mat& img, int y, bool mirrored)
+{
+	const uchar* src = img.ptr<uchar>(y);
+	uchar* dst = gray.ptr<uchar>(y);
+	const int cols = img.cols;
+	const int cn = img.channels();
+
+	if (cn == 1)
+	{
+		if (mirrored)
+		{
+			for (int x = 0; x < cols; ++x)
+				dst[x] = src[cols - 1 - x];
+		}
+		else
+		{
+			std::memcpy(dst, src, cols);
+		}
+		return;
+	}
+
+	if (mirrored)
+	{
+		for (int x = 0; x < cols; ++x)
+		{
+			const uchar* p = src + (cols - 1 - x) * cn;
+			dst[x] = (uchar)((p[0] * weightB + p[1] * weightG + p[2] * weightR + (1 << 13)) >> 14);
+		}
+	}
+	else
+	{
+		for (int x = 0; x < cols; ++x)
+		{
+			const uchar* p = src + x * cn;
+			dst[x] = (uchar)((p[0] * weightB + p[1] * weightG + p[2] * weightR + (1 << 13)) >> 14);
+		}
+	}
+}
+
+void FramePreprocessor::blurRowHorizontal(int y)
+{
+	const uchar* g = gray.ptr<uchar>(y);
+	uint16_t* h = rowsHorizontal.data() + (y % 3) * gray.cols;
+	const int last = gray.cols - 1;
+
+	// BORDER_REFLECT_101, like GaussianBlur
+	h[0] = (uint16_t)(kernelCenter * g[0] + 2 * kernelSide * g[1]);
+	for (int x = 1; x < last; ++x)
+	{
+		h[x] = (uint16_t)(kernelSide * (g[x - 1] + g[x + 1]) + kernelCenter * g[x]);
+	}
+	h[last] = (uint16_t)(kernelCenter * g[last] + 2 * kernelSide * g[last - 1]);
+}
+
+void FramePreprocessor::blurRowVertical(int y)
+{
+	int above = y > 0 ? y - 1 : 1;
+	int below = y < gray.rows - 1 ? y + 1 : gray.rows - 2;
+
+	const uint16_t* a = rowsHorizontal.data() + (above % 3) * gray.cols;
+	const uint16_t* b = rowsHorizontal.data() + (y % 3) * gray.cols;
+	const uint16_t* c = rowsHorizontal.data() + (below % 3) * gray.cols;
+	uchar* dst = blurred.ptr<uchar>(y);
+
+	for (int x = 0; x < gray.cols; ++x)
+	{
+		dst[x] = (uchar)((kernelSide * (a[x] + c[x]) + kernelCenter * b[x] + (1u << 15)) >> 16);
+	}
+}
+
+void FramePreprocessor::process(const Mat& img, bool mirrored)
+{
+	CV_Assert(img.depth() == CV_8U && (img.channels() == 1 || img.channels() == 3 || img.channels() == 4));
+
+	// No allocation after the first frame as long as the frame size does not change
+	gray.create(img.size(), CV_8UC1);
+	blurred.create(img.size(), CV_8UC1);
+
+	if (img.rows < 2 || img.cols < 2)
+	{
+		for (int y = 0; y < img.rows; ++y)
+			convertRow(img, y, mirrored);
+		GaussianBlur(gray, blurred, Size(3, 3), 1);
+		return;
+	}
+
+	rowsHorizontal.resize(3 * img.cols);
+
+	// A blurred row is written as soon as the gray row below it is available, so every row is read from cache
+	for (int y = 0; y < img.rows; ++y)
+	{
+		convertRow(img, y, mirrored);
+		blurRowHorizontal(y);
+		if (y > 0)
+			blurRowVertical(y - 1);
+	}
+	blurRowVertical(img.rows - 1);
+}
+
+const Mat& FramePreprocessor::getGray() const
+{
+	return gray;
+}
+
+const Mat& FramePreprocessor::getBlurred() const
+{
+	return blurred;
+}
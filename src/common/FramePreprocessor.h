@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+
+// Converts a frame to grayscale, mirrors it and applies a 3x3 gaussian blur (sigma 1) in a single pass over the rows.
+// The output buffers are reused between frames, use one instance per worker.
+class FramePreprocessor
+{
+private:
+	cv::Mat gray;
+	cv::Mat blurred;
+	std::vector<uint16_t> rowsHorizontal;	// ring buffer with the last three horizontally blurred rows
+
+	void convertRow(const cv::Mat& img, int y, bool mirrored);
+	void blurRowHorizontal(int y);
+	void blurRowVertical(int y);
+
+public:
+	FramePreprocessor();
+
+	void process(const cv::Mat& img, bool mirrored);
+
+	const cv::Mat& getGray() const;
+	const cv::Mat& getBlurred() const;
+};
+
@@ -77,24 +77,20 @@ Vec4f MirrorPlane::fitPlane(std::vector<cv::Point3f> points)
    return Vec4f(normal[0], normal[1], normal[2], d);
 }
 
-void MirrorPlane::fromFile(const std::string& filePath)
+bool MirrorPlane::fromFile(const std::string& filePath)
 {
     FileStorage fs(filePath, FileStorage::READ + FileStorage::FORMAT_JSON);
     if (!fs.isOpened())
     {
         std::cerr << "[MirrorPlane] Error: Could not open the input file " << filePath << std::endl;
-        exit(1);
+        return false;
     }
 
     fs["plane"] >> planeParams;
     fs.release();
 
     std::cout << "Read plane from file " << filePath << " with params " << planeParams << std::endl;
-}
-
-MirrorPlane::MirrorPlane(const std::vector<Point3f>& points)
-{
-    fromPoints(points);
+    return true;
 }
 
 cv::Vec4f MirrorPlane::getPlaneParams() const
@@ -102,8 +98,14 @@ cv::Vec4f MirrorPlane::getPlaneParams() const
     return planeParams;
 }
 
-void MirrorPlane::fromPoints(std::vector<cv::Point3f> points, int iterations, float inlierThreshold)
+bool MirrorPlane::fromPoints(std::vector<cv::Point3f> points, int iterations, float inlierThreshold)
 {
+    if (points.size() < 3)
+    {
+        std::cerr << "[MirrorPlane]: A plane needs at least 3 points, got " << points.size() << std::endl;
+        return false;
+    }
+
     int bestInliers = 0;
     Vec4f bestPlane;
 
@@ -141,22 +143,18 @@ void MirrorPlane::fromPoints(std::vector<cv::Point3f> points, int iterations, fl
 
     if ((float)bestInliers / points.size() < 0.25)
     {
-        std::cerr << "[MirrorPlane]: Failed to find a suitable candidate for mirror calibration. Only " << std::setprecision(2) << ((float)bestInliers / points.size()) * 100.0f <<  "% was considered an inlier. Aborting..\n";
-        exit(1);
+        std::cerr << "[MirrorPlane]: Failed to find a suitable candidate for mirror calibration. Only " << std::setprecision(2) << ((float)bestInliers / points.size()) * 100.0f <<  "% was considered an inlier.\n";
+        return false;
     }
 
     planeParams = bestPlane;
+    return true;
 }
 
 MirrorPlane::MirrorPlane()
 {
 }
 
-MirrorPlane::MirrorPlane(const std::string& filePath)
-{
-    fromFile(filePath);
-}
-
 std::vector<Point3f> MirrorPlane::reflectPoints(std::vector<Point3f> points)
 {
     Point3f planePt = getPointOnPlane();
@@ -205,20 +203,23 @@ Matx44d MirrorPlane::reflectPose(Matx44d pose)
     return reflectedPose;
 }
 
-void MirrorPlane::saveToJSON(const std::string& filePath)
+bool MirrorPlane::saveToJSON(const std::string& filePath, const std::vector<double>& planeStd)
 {
     Utils::verifyDirectories(filePath);
     FileStorage fs{ filePath, FileStorage::WRITE + FileStorage::FORMAT_JSON };
     if (!fs.isOpened())
     {
         std::cerr << "[MirrorPlane] Error: Could not open the input file " << filePath << std::endl;
-        exit(1);
+        return false;
     }
 
     fs << "plane" << planeParams;
+    if (!planeStd.empty())
+        fs << "plane_std" << planeStd;
     fs.release();
 
     std::cout << "Saved plane to file " << filePath << " with params " << planeParams << std::endl;
+    return true;
 }
 
 
@@ -0,0 +1,317 @@
+#include "PackedRecording.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <opencv2/imgcodecs.hpp>
+#include "Utils.h"
+
+using namespace cv;
+
+static const char packedMagic[4] = { 'P', 'C', 'R', 'C' };
+static const uint32_t packedVersion = 1;
+static const size_t packedAlignment = 64;
+static const size_t initialIndexCapacity = 64;
+
+static uint64_t alignedOffset(uint64_t pos)
+{
+	return (pos + packedAlignment - 1) / packedAlignment * packedAlignment;
+}
+
+PackedRecording::PackedRecording(): data{nullptr}, length{0}
+{
+}
+
+PackedRecording::~PackedRecording()
+{
+	close();
+}
+
+bool PackedRecording::readIndex(std::istream& in, PackedRecordingHeader& header, std::vector<PackedRecordingEntry>& index)
+{
+	in.seekg(0, std::ios::end);
+	uint64_t length = in.tellg();
+	in.seekg(0);
+	in.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!in || std::memcmp(header.magic, packedMagic, 4) != 0 || header.version != packedVersion || header.indexOffset == 0)
+		return false;
+
+	// A corrupt header must not make the index larger than the file
+	if (header.indexOffset > length || header.frameCount > (length - header.indexOffset) / sizeof(PackedRecordingEntry))
+		return false;
+
+	index.resize(header.frameCount);
+	in.seekg(header.indexOffset);
+	in.read(reinterpret_cast<char*>(index.data()), index.size() * sizeof(PackedRecordingEntry));
+	return (bool)in;
+}
+
+bool PackedRecording::open(const std::string& fileName)
+{
+	close();
+
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		std::cerr << "[PackedRecording] Error: Could not open the input file " << fileName << std::endl;
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(PackedRecordingHeader))
+	{
+		std::cerr << "[PackedRecording] Error: " << fileName << " is not a packed recording" << std::endl;
+		::close(fd);
+		return false;
+	}
+
+	// Read only: the mapping is shared by every reader of the recording, frames that are drawn on have to be copied
+	length = st.st_size;
+	void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED)
+	{
+		std::cerr << "[PackedRecording] Error: Could not map " << fileName << std::endl;
+		length = 0;
+		return false;
+	}
+	data = static_cast<uint8_t*>(mapped);
+	madvise(data, length, MADV_SEQUENTIAL);
+
+	const PackedRecordingHeader* header = reinterpret_cast<const PackedRecordingHeader*>(data);
+	if (std::memcmp(header->magic, packedMagic, 4) != 0 || header->version != packedVersion || header->indexOffset == 0
+		|| header->indexOffset > length || header->frameCount > (length - header->indexOffset) / sizeof(PackedRecordingEntry))
+	{
+		std::cerr << "[PackedRecording] Error: " << fileName << " is not a packed recording or was not closed properly" << std::endl;
+		close();
+		return false;
+	}
+
+	const PackedRecordingEntry* entries = reinterpret_cast<const PackedRecordingEntry*>(data + header->indexOffset);
+	index.assign(entries, entries + header->frameCount);
+
+	return true;
+}
+
+void PackedRecording::close()
+{
+	if (data != nullptr)
+	{
+		munmap(data, length);
+		data = nullptr;
+		length = 0;
+	}
+	index.clear();
+}
+
+int PackedRecording::size() const
+{
+	return index.size();
+}
+
+int PackedRecording::getId(int idx) const
+{
+	return index[idx].id;
+}
+
+int PackedRecording::find(int id) const
+{
+	for (size_t i = 0; i < index.size(); ++i)
+	{
+		if (index[i].id == id)
+			return i;
+	}
+	return -1;
+}
+
+Mat PackedRecording::getFrame(int idx) const
+{
+	const PackedRecordingEntry& entry = index[idx];
+
+	// A truncated or corrupt file must not be read past its end
+	if (entry.offset > length || entry.size > length - entry.offset)
+	{
+		std::cerr << "[PackedRecording] Error: Frame " << entry.id << " lies outside of the file" << std::endl;
+		return Mat();
+	}
+
+	if (entry.codec == RAW)
+	{
+		if (entry.rows <= 0 || entry.cols <= 0 || entry.type < 0 || (uint64_t)entry.rows * entry.cols * CV_ELEM_SIZE(entry.type) > entry.size)
+		{
+			std::cerr << "[PackedRecording] Error: Frame " << entry.id << " is larger than its entry" << std::endl;
+			return Mat();
+		}
+		return Mat(entry.rows, entry.cols, entry.type, data + entry.offset);
+	}
+	else
+	{
+		Mat encoded(1, entry.size, CV_8U, data + entry.offset);
+		return imdecode(encoded, IMREAD_UNCHANGED);
+	}
+}
+
+PackedRecordingWriter::PackedRecordingWriter(): codec{PackedRecording::RAW}, grayscale{true}, end{0}, indexOffset{0}, indexCapacity{0}
+{
+}
+
+PackedRecordingWriter::~PackedRecordingWriter()
+{
+	close();
+}
+
+bool PackedRecordingWriter::open(const std::string& fileName, PackedRecording::Codec codec, bool grayscale, bool append)
+{
+	close();
+
+	this->fileName = fileName;
+	this->codec = codec;
+	this->grayscale = grayscale;
+	index.clear();
+	end = 0;
+	indexOffset = 0;
+	indexCapacity = 0;
+
+	Utils::verifyDirectories(fileName);
+
+	if (append && std::filesystem::exists(fileName))
+	{
+		PackedRecordingHeader header;
+		std::ifstream in(fileName, std::ios::binary);
+		if (!PackedRecording::readIndex(in, header, index))
+		{
+			std::cerr << "[PackedRecordingWriter] Error: Could not append to " << fileName << std::endl;
+			return false;
+		}
+		in.close();
+
+		// New frames go behind the old index, which stays valid until the first of them is indexed
+		file.open(fileName, std::ios::in | std::ios::out | std::ios::binary);
+		end = std::filesystem::file_size(fileName);
+		indexOffset = header.indexOffset;
+		indexCapacity = header.frameCount;
+	}
+	else
+	{
+		file.open(fileName, std::ios::out | std::ios::trunc | std::ios::binary);
+		if (file.is_open() && writeHeader())
+		{
+			end = sizeof(PackedRecordingHeader);
+			moveIndex(initialIndexCapacity);
+		}
+	}
+
+	if (!file.is_open() || !file)
+	{
+		std::cerr << "[PackedRecordingWriter] Error: Could not open the output file " << fileName << std::endl;
+		file.close();
+		return false;
+	}
+
+	return true;
+}
+
+bool PackedRecordingWriter::writeHeader()
+{
+	// Everything the header points to has to be in the file first
+	file.flush();
+
+	PackedRecordingHeader header{};
+	std::memcpy(header.magic, packedMagic, 4);
+	header.version = packedVersion;
+	header.frameCount = index.size();
+	header.indexOffset = indexOffset;
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.flush();
+	return (bool)file;
+}
+
+bool PackedRecordingWriter::moveIndex(size_t capacity)
+{
+	uint64_t offset = alignedOffset(end);
+	std::vector<PackedRecordingEntry> entries(capacity);
+	std::copy(index.begin(), index.end(), entries.begin());
+
+	static const char zeros[packedAlignment] = {};
+	file.seekp(end);
+	file.write(zeros, offset - end);
+	file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(PackedRecordingEntry));
+
+	end = offset + capacity * sizeof(PackedRecordingEntry);
+	indexOffset = offset;
+	indexCapacity = capacity;
+	return writeHeader();
+}
+
+bool PackedRecordingWriter::write(int id, const Mat& frame)
+{
+	if (!isOpened() || frame.empty())
+		return false;
+
+	Mat img = frame;
+	if (grayscale)
+		Utils::toGray(frame, img);
+	if (!img.isContinuous())
+		img = img.clone();
+
+	uint64_t pos = alignedOffset(end);
+	static const char zeros[packedAlignment] = {};
+	file.seekp(end);
+	file.write(zeros, pos - end);
+
+	PackedRecordingEntry entry{};
+	entry.id = id;
+	entry.rows = img.rows;
+	entry.cols = img.cols;
+	entry.type = img.type();
+	entry.codec = codec;
+	entry.offset = pos;
+
+	if (codec == PackedRecording::RAW)
+	{
+		entry.size = img.total() * img.elemSize();
+		file.write(reinterpret_cast<const char*>(img.data), entry.size);
+	}
+	else
+	{
+		std::vector<uchar> buffer;
+		imencode(".png", img, buffer, { IMWRITE_PNG_COMPRESSION, 1 });
+		entry.size = buffer.size();
+		file.write(reinterpret_cast<const char*>(buffer.data()), entry.size);
+	}
+	end = pos + entry.size;
+
+	// The entry goes to spare room in the index, or a larger copy of the index goes behind the frame. The header only
+	// counts the frame once its entry is written.
+	index.push_back(entry);
+	if (index.size() > indexCapacity)
+		return moveIndex(std::max(initialIndexCapacity, 2 * indexCapacity));
+
+	file.seekp(indexOffset + (index.size() - 1) * sizeof(PackedRecordingEntry));
+	file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+	return writeHeader();
+}
+
+void PackedRecordingWriter::close()
+{
+	if (!isOpened())
+		return;
+
+	// A closed recording has an index without spare room at its end
+	if (indexOffset + index.size() * sizeof(PackedRecordingEntry) != end)
+		moveIndex(index.size());
+	file.close();
+
+	std::cout << "[PackedRecordingWriter] Wrote " << index.size() << " frames to " << fileName << std::endl;
+	index.clear();
+}
+
+bool PackedRecordingWriter::isOpened() const
+{
+	return file.is_open();
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+
+// File layout: header | frames (64 byte aligned) | index
+// While recording the index has spare room and lies between the frames, it is copied behind the last frame when it is
+// full. The header is rewritten after every frame and nothing it points to is overwritten, so a recording that was
+// not closed keeps its frames up to the last complete one.
+struct PackedRecordingHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t frameCount;
+	uint32_t reserved;
+	uint64_t indexOffset;
+};
+
+struct PackedRecordingEntry
+{
+	int32_t id;
+	int32_t rows;
+	int32_t cols;
+	int32_t type;
+	uint32_t codec;
+	uint32_t reserved;
+	uint64_t offset;
+	uint64_t size;
+};
+
+class PackedRecording
+{
+public:
+	enum Codec : uint32_t
+	{
+		RAW = 0,	// frames are mapped without copying
+		PNG = 1		// fast PNG compression, decoded from the mapped memory
+	};
+
+	PackedRecording();
+	~PackedRecording();
+
+	PackedRecording(const PackedRecording&) = delete;
+	PackedRecording& operator=(const PackedRecording&) = delete;
+
+	bool open(const std::string& fileName);
+	void close();
+
+	int size() const;
+	int getId(int idx) const;
+	int find(int id) const;
+	// RAW frames are read only views of the mapped file, empty when the entry does not fit in the file
+	cv::Mat getFrame(int idx) const;
+
+	static bool readIndex(std::istream& in, PackedRecordingHeader& header, std::vector<PackedRecordingEntry>& index);
+
+private:
+	uint8_t* data;
+	size_t length;
+	std::vector<PackedRecordingEntry> index;
+};
+
+class PackedRecordingWriter
+{
+private:
+	std::fstream file;
+	std::string fileName;
+	PackedRecording::Codec codec;
+	bool grayscale;
+	std::vector<PackedRecordingEntry> index;
+
+	uint64_t end;
+	uint64_t indexOffset;
+	size_t indexCapacity;
+
+	bool writeHeader();
+	bool moveIndex(size_t capacity);
+
+public:
+	PackedRecordingWriter();
+	~PackedRecordingWriter();
+
+	bool open(const std::string& fileName, PackedRecording::Codec codec = PackedRecording::RAW, bool grayscale = true, bool append = false);
+	bool write(int id, const cv::Mat& frame);
+	void close();
+
+	bool isOpened() const;
+};
+
@@ -0,0 +1,110 @@
+#include "SettleDetector.h"
+#include "Utils.h"
+#include <opencv2/imgproc.hpp>
+
+using namespace cv;
+
+SettleDetector::SettleDetector(int stillFrames, int timeoutMs, int width): stillFrames{stillFrames}, timeoutMs{timeoutMs}, width{width}, changed{false}, timedOut{false}, nrStill{0}, changeLatency{0}, settleLatency{0}
+{
+}
+
+void SettleDetector::shrink(const Mat& frame, Mat& out) const
+{
+	Mat gray;
+	Utils::toGray(frame, gray);
+
+	// Area averaging also suppresses most of the sensor noise, at full resolution a small blur does that
+	if (width <= 0 || width >= gray.cols)
+	{
+		GaussianBlur(gray, out, Size(3, 3), 0);
+		return;
+	}
+	double scale = (double)width / gray.cols;
+	resize(gray, out, Size(), scale, scale, INTER_AREA);
+}
+
+void SettleDetector::setTimeout(int timeoutMs)
+{
+	this->timeoutMs = timeoutMs;
+}
+
+double SettleDetector::differentFraction(const Mat& a, const Mat& b)
+{
+	absdiff(a, b, diff);
+	threshold(diff, diff, diffThreshold, 255, THRESH_BINARY);
+	return (double)countNonZero(diff) / diff.total();
+}
+
+double SettleDetector::elapsedMs() const
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void SettleDetector::reset(const Mat& reference)
+{
+	shrink(reference, this->reference);
+	previous.release();
+	changed = false;
+	timedOut = false;
+	nrStill = 0;
+	changeLatency = 0;
+	settleLatency = 0;
+	start = std::chrono::steady_clock::now();
+}
+
+bool SettleDetector::update(const Mat& frame)
+{
+	shrink(frame, small);
+
+	if (!changed)
+	{
+		if (differentFraction(small, reference) > changedFraction)
+		{
+			changed = true;
+			changeLatency = elapsedMs();
+		}
+		else if (timeoutMs > 0 && elapsedMs() > timeoutMs)
+		{
+			changed = true;
+			timedOut = true;
+			changeLatency = elapsedMs();
+		}
+	}
+	else if (!previous.empty() && differentFraction(small, previous) < stillFraction)
+	{
+		++nrStill;
+	}
+	else
+	{
+		nrStill = 0;
+	}
+
+	small.copyTo(previous);
+
+	if (changed && nrStill >= stillFrames)
+	{
+		settleLatency = elapsedMs();
+		return true;
+	}
+	return false;
+}
+
+bool SettleDetector::hasChanged() const
+{
+	return changed;
+}
+
+bool SettleDetector::hasTimedOut() const
+{
+	return timedOut;
+}
+
+double SettleDetector::getChangeLatency() const
+{
+	return changeLatency;
+}
+
+double SettleDetector::getSettleLatency() const
+{
+	return settleLatency;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <chrono>
+#include <opencv2/core.hpp>
+
+// Decides from consecutive camera frames when the scene changed and came to rest, so a capture is taken as soon as a
+// new projector pattern is stably visible, or as soon as the board was moved to a new pose and held still, instead of
+// after a fixed delay. Frames are compared on a grayscale copy scaled to the given width, a pixel counts as different when
+// it changed by more than diffThreshold gray levels.
+class SettleDetector
+{
+private:
+	int stillFrames;
+	int timeoutMs;
+	int width;
+
+	static const int diffThreshold = 12;
+	// Fractions of the pixels that have to differ from the reference, and may differ between still frames
+	static constexpr double changedFraction = 0.01;
+	static constexpr double stillFraction = 0.002;
+
+	cv::Mat reference;
+	cv::Mat previous;
+	cv::Mat small;
+	cv::Mat diff;
+
+	bool changed;
+	bool timedOut;
+	int nrStill;
+
+	std::chrono::steady_clock::time_point start;
+	double changeLatency;
+	double settleLatency;
+
+	void shrink(const cv::Mat& frame, cv::Mat& out) const;
+	double differentFraction(const cv::Mat& a, const cv::Mat& b);
+	double elapsedMs() const;
+
+public:
+	// A timeout of 0 waits for a change forever. A width of 0 compares at full resolution, fine structured light patterns
+	// (1 pixel line shifts, the last Gray code bits) are averaged away in a small copy.
+	SettleDetector(int stillFrames = 2, int timeoutMs = 0, int width = 160);
+
+	// Applies from the next reset
+	void setTimeout(int timeoutMs);
+
+	// Starts waiting for a change away from the reference frame, the latencies are measured from here
+	void reset(const cv::Mat& reference);
+
+	// True once a frame differed from the reference and the last stillFrames frames agreed with each other. When nothing
+	// changes before the timeout, e.g. two patterns that look the same in the camera, the scene is taken as changed.
+	bool update(const cv::Mat& frame);
+
+	bool hasChanged() const;
+	bool hasTimedOut() const;
+
+	// Milliseconds from reset to the first changed frame, and to the frame the scene settled in
+	double getChangeLatency() const;
+	double getSettleLatency() const;
+};
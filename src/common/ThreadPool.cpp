@@ -0,0 +1,72 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(int nrThreads): running{0}, stopping{false}
+{
+	if (nrThreads <= 0)
+		nrThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	for (int i = 0; i < nrThreads; ++i)
+	{
+		workers.emplace_back(&ThreadPool::run, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	taskAvailable.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+void ThreadPool::run(int worker)
+{
+	while (true)
+	{
+		std::function<void(int)> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+			if (tasks.empty())
+				return;
+
+			task = std::move(tasks.front());
+			tasks.pop_front();
+			++running;
+		}
+
+		task(worker);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			--running;
+			if (running == 0 && tasks.empty())
+				idle.notify_all();
+		}
+	}
+}
+
+void ThreadPool::submit(std::function<void(int)> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push_back(std::move(task));
+	}
+	taskAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	idle.wait(lock, [this] { return running == 0 && tasks.empty(); });
+}
+
+int ThreadPool::size() const
+{
+	return (int)workers.size();
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads executing tasks in submission order. Tasks get the index of the worker that runs them,
+// so per worker state (detectors, buffers) can be kept next to the pool and reused between tasks.
+class ThreadPool
+{
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::function<void(int)>> tasks;
+
+	std::mutex mutex;
+	std::condition_variable taskAvailable;
+	std::condition_variable idle;
+	int running;
+	bool stopping;
+
+	void run(int worker);
+
+public:
+	// nrThreads <= 0 uses the number of cores
+	ThreadPool(int nrThreads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Can also be called from a running task, e.g. to queue the next stage of a job
+	void submit(std::function<void(int)> task);
+
+	// Blocks until the queue is empty and no task is running
+	void wait();
+
+	int size() const;
+};
+
@@ -0,0 +1,107 @@
+#include "Uncertainty.h"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <iostream>
+#include <random>
+#include "ThreadPool.h"
+
+bool Uncertainty::parse(const std::string& name, Method& method)
+{
+	if (name == "bootstrap")
+		method = BOOTSTRAP;
+	else if (name == "loo")
+		method = LEAVE_ONE_OUT;
+	else if (name == "none")
+		method = NONE;
+	else
+	{
+		std::cerr << "[Uncertainty] Unknown method " << name << ", use bootstrap, loo or none" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+std::vector<double> Uncertainty::estimate(Method method, int nrViews, int resamples, const Solver& solve, unsigned seed)
+{
+	if (method == NONE || nrViews < 2 || resamples < 2)
+		return {};
+
+	std::vector<std::vector<int>> samples;
+	if (method == BOOTSTRAP)
+	{
+		std::mt19937 gen(seed);
+		std::uniform_int_distribution<> dis(0, nrViews - 1);
+		samples.resize(resamples);
+		for (auto& sample : samples)
+		{
+			for (int i = 0; i < nrViews; ++i)
+				sample.push_back(dis(gen));
+		}
+	}
+	else
+	{
+		int groups = std::min(nrViews, resamples);
+		samples.resize(groups);
+		for (int g = 0; g < groups; ++g)
+		{
+			int begin = g * nrViews / groups;
+			int end = (g + 1) * nrViews / groups;
+			for (int i = 0; i < nrViews; ++i)
+			{
+				if (i < begin || i >= end)
+					samples[g].push_back(i);
+			}
+		}
+	}
+
+	std::vector<std::vector<double>> results(samples.size());
+	{
+		ThreadPool pool;
+		for (size_t i = 0; i < samples.size(); ++i)
+		{
+			pool.submit([&, i](int)
+			{
+				// A resample can be degenerate, an exception on a pool thread would terminate the process
+				try
+				{
+					results[i] = solve(samples[i]);
+				}
+				catch (const std::exception& e)
+				{
+					std::cerr << "[Uncertainty] Resample " << i << " failed: " << e.what() << std::endl;
+					results[i].clear();
+				}
+			});
+		}
+		pool.wait();
+	}
+
+	results.erase(std::remove_if(results.begin(), results.end(), [](const std::vector<double>& r) { return r.empty(); }), results.end());
+	std::cout << "[Uncertainty] Solved " << results.size() << " of " << samples.size() << " resamples" << std::endl;
+	if (results.size() < 2)
+		return {};
+
+	size_t nrParams = results[0].size();
+	double n = results.size();
+	std::vector<double> stds(nrParams);
+	for (size_t p = 0; p < nrParams; ++p)
+	{
+		double mean = 0;
+		for (const auto& r : results)
+			mean += r[p];
+		mean /= n;
+
+		double squares = 0;
+		for (const auto& r : results)
+			squares += (r[p] - mean) * (r[p] - mean);
+
+		// The jackknife spreads are (n - 1) times smaller than those of independent samples
+		if (method == BOOTSTRAP)
+			stds[p] = std::sqrt(squares / (n - 1));
+		else
+			stds[p] = std::sqrt(squares * (n - 1) / n);
+	}
+
+	return stds;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+// Standard deviation of every parameter of a calibration, estimated by solving it again on resamples of its views.
+// The resamples are solved concurrently on all cores.
+class Uncertainty
+{
+public:
+	enum Method
+	{
+		NONE,
+		BOOTSTRAP,		// resamples of all views drawn with replacement
+		LEAVE_ONE_OUT	// jackknife, every resample leaves out one view, or one group of views when there are more views than resamples
+	};
+
+	// Gets the views of one resample, with repetitions for the bootstrap, and returns the parameters solved from them.
+	// An empty result or an exception leaves the resample out.
+	typedef std::function<std::vector<double>(const std::vector<int>& views)> Solver;
+
+	static bool parse(const std::string& name, Method& method);
+
+	static std::vector<double> estimate(Method method, int nrViews, int resamples, const Solver& solve, unsigned seed = 0);
+};
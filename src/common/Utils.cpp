@@ -1,13 +1,64 @@
 #include "Utils.h"
+#include <algorithm>
 #include <filesystem>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <iostream>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
 #include "DeviceFactory/CameraCalibration.h"
+#include "PackedRecording.h"
+#include "Config.h"
 // #include <windows.h>
 
 
+// Packed recordings stay mapped for the lifetime of the process, frames are views into the mapping
+static std::shared_ptr<PackedRecording> getPackedRecording(const std::string& fileName)
+{
+	static std::mutex packedMutex;
+	static std::map<std::string, std::shared_ptr<PackedRecording>> packedRecordings;
+
+	std::lock_guard<std::mutex> lock(packedMutex);
+	auto it = packedRecordings.find(fileName);
+	if (it != packedRecordings.end())
+		return it->second;
+
+	auto recording = std::make_shared<PackedRecording>();
+	if (!recording->open(fileName))
+		return nullptr;
+
+	packedRecordings[fileName] = recording;
+	return recording;
+}
+
 std::vector<std::string> Utils::loadImages(const std::string& folderPath)
 {
+	// A packed recording is used instead of the images when present, entries are "<pack file>#<id>"
+	std::string packPath = folderPath;
+	if (std::filesystem::is_directory(folderPath))
+		packPath = (std::filesystem::path(folderPath) / Config::packedRecordingFile).string();
+
+	if (std::filesystem::is_regular_file(packPath))
+	{
+		std::vector<std::string> entries;
+		auto recording = getPackedRecording(packPath);
+		if (recording == nullptr)
+			return entries;
+
+		std::map<int, std::string> ids;
+		for (int i = 0; i < recording->size(); ++i)
+		{
+			ids[recording->getId(i)] = packPath + "#" + std::to_string(recording->getId(i));
+		}
+		for (auto pair : ids)
+		{
+			entries.push_back(pair.second);
+		}
+		std::cout << "Loaded: " << entries.size() << " frames from " << packPath << std::endl;
+		return entries;
+	}
+
 	std::map<int, std::string> filenames;
 	for (const auto& entry : std::filesystem::directory_iterator(folderPath))
 	{
@@ -32,6 +83,41 @@ std::vector<std::string> Utils::loadImages(const std::string& folderPath)
 	return paths;
 }
 
+cv::Mat Utils::readImage(const std::string& entry, bool grayscale)
+{
+	// Only "<existing file>#<id>" is a frame of a packed recording, other paths can contain '#' as well
+	size_t separator = entry.rfind('#');
+	std::string id = separator != std::string::npos ? entry.substr(separator + 1) : "";
+	if (!id.empty() && id.size() < 10 && std::all_of(id.begin(), id.end(), ::isdigit) && std::filesystem::is_regular_file(entry.substr(0, separator)))
+	{
+		auto recording = getPackedRecording(entry.substr(0, separator));
+		if (recording == nullptr)
+			return cv::Mat();
+
+		int idx = recording->find(std::stoi(id));
+		if (idx < 0)
+			return cv::Mat();
+
+		cv::Mat frame = recording->getFrame(idx);
+		if (grayscale)
+			toGray(frame, frame);
+		return frame;
+	}
+
+	// The decoder converts to a single channel, no BGR image is allocated
+	return cv::imread(entry, grayscale ? cv::IMREAD_GRAYSCALE : cv::IMREAD_COLOR);
+}
+
+void Utils::toGray(const cv::Mat& img, cv::Mat& gray)
+{
+	if (img.channels() == 3)
+		cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
+	else if (img.channels() == 4)
+		cv::cvtColor(img, gray, cv::COLOR_BGRA2GRAY);
+	else
+		gray = img;
+}
+
 cv::Matx44d Utils::extrinsicFromRt(cv::Matx33d R, cv::Matx31d t)
 {
 	cv::Matx44d extrinsic = cv::Matx44d::eye();
@@ -10,6 +10,8 @@ class Utils
 {
 public:
 	static std::vector<std::string> loadImages(const std::string& folderPath);
+	static cv::Mat readImage(const std::string& entry, bool grayscale = false);
+	static void toGray(const cv::Mat& img, cv::Mat& gray);
 	static cv::Matx44d extrinsicFromRt(cv::Matx33d R, cv::Matx31d t);
 	static void flip2dPoints(std::vector<cv::Point2f>& points2d, int imgWidth);
 	static void verifyDirectories(const std::string& filepath);
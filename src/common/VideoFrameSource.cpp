@@ -0,0 +1,128 @@
+#include "VideoFrameSource.h"
+#include <iostream>
+#include <limits>
+#include "DeviceFactory/DeviceFactory.h"
+
+using namespace cv;
+
+VideoFrameSource::VideoFrameSource(): decodedFrames{0}, inRangeFrames{0}, frameTime{-1.0}
+{
+}
+
+bool VideoFrameSource::open(const std::string& videoPath, const VideoSampling& sampling)
+{
+	this->sampling = sampling;
+	if (this->sampling.stride < 1)
+		this->sampling.stride = 1;
+
+	decodedFrames = 0;
+	inRangeFrames = 0;
+	frameTime = -1.0;
+
+	DeviceFactory::DeviceProperties properties;
+	if (sampling.keyframesOnly)
+		properties["keyframes"] = "1";
+	if (sampling.grayscale)
+		properties["grayscale"] = "1";
+
+	DeviceFactory::DeviceFactory df;
+	device = df.createDevices("FFMPEG", videoPath, properties);
+	if (device.get() == nullptr)
+	{
+		std::cout << "[VideoFrameSource] FFMPEG decoder not available, using CVVideoCapture for " << videoPath << std::endl;
+		if (sampling.keyframesOnly)
+			std::cerr << "[VideoFrameSource] Key frame sampling requires the FFMPEG decoder, decoding all frames" << std::endl;
+		device = df.createDevices("CVVideoCapture", videoPath, properties);
+	}
+
+	if (device.get() == nullptr)
+	{
+		std::cerr << "[VideoFrameSource] Error: Could not open video " << videoPath << std::endl;
+		return false;
+	}
+
+	// Frames before the start are still decoded and dropped when seeking is not supported
+	if (sampling.startTime > 0.0 && !device->seek(sampling.startTime))
+	{
+		std::cerr << "[VideoFrameSource] Seeking not supported, decoding up to " << sampling.startTime << "s" << std::endl;
+	}
+
+	std::cout << "[VideoFrameSource] Opened " << videoPath << " (" << getFrameRate() << " fps, stride " << this->sampling.stride << ")" << std::endl;
+	return true;
+}
+
+double VideoFrameSource::currentTime()
+{
+	double position = device->framePosition();
+	if (position >= 0.0)
+		return position;
+
+	double fps = device->frameRate();
+	if (fps > 0.0)
+		return (decodedFrames - 1) / fps;
+
+	return decodedFrames - 1;
+}
+
+bool VideoFrameSource::next(Mat& frame)
+{
+	if (device.get() == nullptr)
+		return false;
+
+	while (true)
+	{
+		Mat img; double timestamp;
+		device->captureImages(img, timestamp);
+		if (img.empty())
+			return false;
+
+		++decodedFrames;
+		frameTime = currentTime();
+
+		if (frameTime < sampling.startTime)
+			continue;
+
+		if (sampling.endTime >= 0.0 && frameTime > sampling.endTime)
+			return false;
+
+		++inRangeFrames;
+		if ((inRangeFrames - 1) % sampling.stride != 0)
+			continue;
+
+		frame = img;
+		return true;
+	}
+}
+
+double VideoFrameSource::getFrameTime() const
+{
+	return frameTime;
+}
+
+double VideoFrameSource::getFrameRate() const
+{
+	if (device.get() == nullptr)
+		return 0.0;
+	return device->frameRate();
+}
+
+double VideoFrameSource::getStartTime() const
+{
+	return sampling.startTime;
+}
+
+double VideoFrameSource::getEndTime() const
+{
+	if (sampling.endTime >= 0.0)
+		return sampling.endTime;
+
+	if (device.get() == nullptr)
+		return -1.0;
+
+	int frames = device->numberOfFrames();
+	double fps = device->frameRate();
+	if (frames == std::numeric_limits<int>::max() || fps <= 0.0)
+		return -1.0;
+
+	return frames / fps;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <opencv2/core.hpp>
+#include "DeviceFactory/Device.h"
+
+struct VideoSampling
+{
+	int stride = 1;				// use every n-th frame inside the time range
+	double startTime = 0.0;		// seconds
+	double endTime = -1.0;		// seconds, negative until the end of the video
+	bool keyframesOnly = false;	// only decode key frames (FFMPEG only)
+	bool grayscale = false;		// decode to single channel frames
+};
+
+class VideoFrameSource
+{
+private:
+	std::shared_ptr<DeviceFactory::Device> device;
+	VideoSampling sampling;
+
+	int decodedFrames;
+	int inRangeFrames;
+	double frameTime;
+
+	double currentTime();
+
+public:
+	VideoFrameSource();
+
+	bool open(const std::string& videoPath, const VideoSampling& sampling = VideoSampling());
+
+	bool next(cv::Mat& frame);
+
+	double getFrameTime() const;
+	double getFrameRate() const;
+	double getStartTime() const;
+	double getEndTime() const;
+};
+
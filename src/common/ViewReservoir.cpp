@@ -0,0 +1,108 @@
+#include "ViewReservoir.h"
+#include <algorithm>
+#include <opencv2/imgproc.hpp>
+
+using namespace cv;
+
+ViewReservoir::ViewReservoir(int capacity, unsigned seed): capacity{capacity}, binSlots(gridCols * gridRows * sizeBins), binSeen(gridCols * gridRows * sizeBins, 0), seen{0}, gen(seed)
+{
+}
+
+void ViewReservoir::setCapacity(int capacity)
+{
+	this->capacity = capacity;
+}
+
+int ViewReservoir::binOf(InputArray imagePoints, const Size& frameSize) const
+{
+	Rect2f box = boundingRect(imagePoints);
+	Point2f center = (box.tl() + box.br()) * 0.5f;
+
+	int col = std::clamp((int)(center.x * gridCols / frameSize.width), 0, gridCols - 1);
+	int row = std::clamp((int)(center.y * gridRows / frameSize.height), 0, gridRows - 1);
+
+	// Far, middle and close boards, by the fraction of the image their bounding box covers
+	float coverage = box.area() / frameSize.area();
+	int size = coverage < 0.05f ? 0 : (coverage < 0.2f ? 1 : 2);
+
+	return (row * gridCols + col) * sizeBins + size;
+}
+
+int ViewReservoir::offer(InputArray imagePoints, const Size& frameSize)
+{
+	int bin = binOf(imagePoints, frameSize);
+	++binSeen[bin];
+	++seen;
+
+	if (capacity <= 0 || size() < capacity)
+	{
+		slotBins.push_back(bin);
+		binSlots[bin].push_back(size() - 1);
+		return size() - 1;
+	}
+
+	auto fullest = std::max_element(binSlots.begin(), binSlots.end(), [](const std::vector<int>& a, const std::vector<int>& b) { return a.size() < b.size(); });
+
+	// Moving a view to a less covered bin
+	if (binSlots[bin].size() + 1 < fullest->size())
+	{
+		std::uniform_int_distribution<size_t> dis(0, fullest->size() - 1);
+		size_t i = dis(gen);
+		int slot = (*fullest)[i];
+		(*fullest)[i] = fullest->back();
+		fullest->pop_back();
+
+		binSlots[bin].push_back(slot);
+		slotBins[slot] = bin;
+		return slot;
+	}
+
+	// Every view of the bin has the same chance to be kept
+	std::uniform_int_distribution<long long> dis(0, binSeen[bin] - 1);
+	long long r = dis(gen);
+	if (r < (long long)binSlots[bin].size())
+		return binSlots[bin][r];
+
+	return -1;
+}
+
+void ViewReservoir::remove(const std::vector<int>& slots)
+{
+	std::vector<int> newSlots(size(), 0);
+	for (int slot : slots)
+		newSlots[slot] = -1;
+
+	std::vector<int> keptBins;
+	for (int slot = 0; slot < size(); ++slot)
+	{
+		if (newSlots[slot] < 0)
+			continue;
+		newSlots[slot] = keptBins.size();
+		keptBins.push_back(slotBins[slot]);
+	}
+	slotBins = keptBins;
+
+	for (auto& bin : binSlots)
+	{
+		bin.erase(std::remove_if(bin.begin(), bin.end(), [&](int slot) { return newSlots[slot] < 0; }), bin.end());
+		for (int& slot : bin)
+			slot = newSlots[slot];
+	}
+}
+
+int ViewReservoir::size() const
+{
+	return slotBins.size();
+}
+
+long long ViewReservoir::getSeen() const
+{
+	return seen;
+}
+
+void ViewReservoir::printSummary(std::ostream& os) const
+{
+	int binsSeen = std::count_if(binSeen.begin(), binSeen.end(), [](long long n) { return n > 0; });
+	int binsKept = std::count_if(binSlots.begin(), binSlots.end(), [](const std::vector<int>& slots) { return !slots.empty(); });
+	os << "[ViewReservoir] Kept " << size() << " of " << seen << " views, covering " << binsKept << " of the " << binsSeen << " position and size bins that were seen" << std::endl;
+}
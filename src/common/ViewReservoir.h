@@ -0,0 +1,45 @@
+#pragma once
+#include <ostream>
+#include <random>
+#include <vector>
+#include <opencv2/core.hpp>
+
+// Bounded set of calibration views, for recordings with more views than should be kept in memory. Views are binned by
+// where the board is in the camera image and by how much of the image it covers. When the reservoir is full, the
+// fullest bin gives up a random view for a view of a less covered bin, and otherwise a bin keeps a uniform sample of
+// all of its views (reservoir sampling). The reservoir only picks the slots, the calibrators store the views.
+class ViewReservoir
+{
+private:
+	static const int gridCols = 4;
+	static const int gridRows = 4;
+	static const int sizeBins = 3;
+
+	// 0 keeps every view
+	int capacity;
+
+	std::vector<int> slotBins;
+	std::vector<std::vector<int>> binSlots;
+	std::vector<long long> binSeen;
+	long long seen;
+
+	std::mt19937 gen;
+
+	int binOf(cv::InputArray imagePoints, const cv::Size& frameSize) const;
+
+public:
+	ViewReservoir(int capacity = 0, unsigned seed = 0);
+
+	void setCapacity(int capacity);
+
+	// Slot to store the view in: size() to append it, a smaller slot to replace the view in it, or -1 to drop it
+	int offer(cv::InputArray imagePoints, const cv::Size& frameSize);
+
+	// Frees the slots of views the calibrator removed, the later slots move down as in CorrespondenceArena::remove
+	void remove(const std::vector<int>& slots);
+
+	int size() const;
+	long long getSeen() const;
+
+	void printSummary(std::ostream& os) const;
+};